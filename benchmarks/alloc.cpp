@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "obj.hpp"
+#include "stl.hpp"
+#include "calc.hpp"
+
+// Every heap allocation of this binary goes through the counting operator new below,
+// each benchmark reports allocations per iteration of its stage of the obj -> stl path
+static std::atomic<size_t> allocations_count {0};
+
+void* operator new(size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+static const std::string complex_path = "../../tests/resources/complex.obj";
+
+template<typename Stage>
+static void count_allocations(benchmark::State& state, Stage const& stage) {
+    size_t count = 0;
+
+    for (auto _ : state) {
+        const auto before = allocations_count.load(std::memory_order_relaxed);
+        stage();
+        count += allocations_count.load(std::memory_order_relaxed) - before;
+    }
+
+    state.counters["allocs"] = benchmark::Counter(double(count), benchmark::Counter::kAvgIterations);
+}
+
+static void bm_allocs_load_layout_complex(benchmark::State& state) {
+    count_allocations(state, [] {
+        benchmark::DoNotOptimize(obj_file::load_mesh_layout_from_file(complex_path));
+    });
+}
+
+static void bm_allocs_polygons_complex(benchmark::State& state) {
+    const auto layout = obj_file::load_mesh_layout_from_file(complex_path);
+
+    count_allocations(state, [&layout] {
+        mesh::MeshLayoutReader reader(layout, std::make_shared<mesh::FanTriangulationStrategy>());
+        benchmark::DoNotOptimize(reader.polygons());
+    });
+}
+
+static void bm_allocs_triangles_complex(benchmark::State& state) {
+    const auto layout = obj_file::load_mesh_layout_from_file(complex_path);
+
+    count_allocations(state, [&layout] {
+        mesh::MeshLayoutReader reader(layout, std::make_shared<mesh::FanTriangulationStrategy>());
+        benchmark::DoNotOptimize(reader.triangles());
+    });
+}
+
+static void bm_allocs_surface_area_complex(benchmark::State& state) {
+    const auto layout = obj_file::load_mesh_layout_from_file(complex_path);
+
+    count_allocations(state, [&layout] {
+        benchmark::DoNotOptimize(calc::calculate_surface_area(layout));
+    });
+}
+
+static void bm_allocs_convert_to_stl_complex(benchmark::State& state) {
+    const auto layout = obj_file::load_mesh_layout_from_file(complex_path);
+
+    count_allocations(state, [&layout] {
+        auto transformed_layout = calc::apply_transforms_to_layout(
+            layout,
+            glm::vec3(1, 2, 3),
+            glm::vec3(0, 0, 0),
+            glm::vec3(1, 1, 1)
+        );
+
+        stl_file::StlMeshWriter writer;
+        benchmark::DoNotOptimize(writer.write(transformed_layout));
+    });
+}
+
+BENCHMARK(bm_allocs_load_layout_complex);
+BENCHMARK(bm_allocs_polygons_complex);
+BENCHMARK(bm_allocs_triangles_complex);
+BENCHMARK(bm_allocs_surface_area_complex);
+BENCHMARK(bm_allocs_convert_to_stl_complex);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include "format.hpp"
+
+// A million floats, the size of an stl of 83k triangles
+static const std::vector<float> values(1 << 20, 1.5f);
+
+static void bm_write_float(benchmark::State& state) {
+    const auto byte_order = mesh_format::ByteOrder(state.range(0));
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, byte_order);
+
+    for (auto _ : state) {
+        writer.clear();
+
+        for (const auto value : values) {
+            writer.write_float(value);
+        }
+
+        benchmark::DoNotOptimize(writer.get_bytes().data());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * values.size() * sizeof(float)));
+}
+
+static void bm_write_floats(benchmark::State& state) {
+    const auto byte_order = mesh_format::ByteOrder(state.range(0));
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, byte_order);
+
+    for (auto _ : state) {
+        writer.clear();
+        writer.write_floats(values.data(), values.size());
+
+        benchmark::DoNotOptimize(writer.get_bytes().data());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * values.size() * sizeof(float)));
+}
+
+// Records of an stl triangle, 12 floats and 2 bytes of padding
+static void bm_write_record(benchmark::State& state) {
+    const auto byte_order = mesh_format::ByteOrder(state.range(0));
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, byte_order);
+
+    for (auto _ : state) {
+        writer.clear();
+
+        for (size_t i = 0; i + 12 <= values.size(); i += 12) {
+            writer.write_record(values.data() + i, 12, 2);
+        }
+
+        benchmark::DoNotOptimize(writer.get_bytes().data());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * values.size() * sizeof(float)));
+}
+
+// Args are the ByteOrder, little endian and big endian
+BENCHMARK(bm_write_float)->Arg(0)->Arg(1);
+BENCHMARK(bm_write_floats)->Arg(0)->Arg(1);
+BENCHMARK(bm_write_record)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
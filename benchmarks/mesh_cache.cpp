@@ -0,0 +1,37 @@
+#include <benchmark/benchmark.h>
+
+#include "obj.hpp"
+#include "mesh_cache.hpp"
+
+static const std::string complex_path = "../../tests/resources/complex.obj";
+static const std::string complex_cache_path = "complex.meshcache";
+
+static void bm_load_layout_cold_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(obj_file::load_mesh_layout_from_file(complex_path));
+    }
+}
+
+static void bm_load_layout_warm_complex(benchmark::State& state) {
+    const auto key = mesh_cache::get_source_key(complex_path);
+    mesh_cache::write_to_file(complex_cache_path, key, *obj_file::load_mesh_layout_from_file(complex_path));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mesh_cache::read_from_file(complex_cache_path, key));
+    }
+}
+
+static void bm_write_cache_complex(benchmark::State& state) {
+    const auto key = mesh_cache::get_source_key(complex_path);
+    const auto layout = obj_file::load_mesh_layout_from_file(complex_path);
+
+    for (auto _ : state) {
+        mesh_cache::write_to_file(complex_cache_path, key, *layout);
+    }
+}
+
+BENCHMARK(bm_load_layout_cold_complex);
+BENCHMARK(bm_load_layout_warm_complex);
+BENCHMARK(bm_write_cache_complex);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <random>
+
+#include "normals.hpp"
+#include "utils.hpp"
+
+// Enough blocks to go past the caches, like the normals of a large mesh
+static constexpr size_t blocks_count = 1 << 14;
+
+static const std::vector<normals::TriangleBlock> blocks = [] {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+    std::vector<normals::TriangleBlock> blocks(blocks_count);
+
+    for (auto& block : blocks) {
+        for (auto& lanes : block.corners) {
+            for (auto& value : lanes) {
+                value = coordinate(random);
+            }
+        }
+    }
+
+    return blocks;
+}();
+
+static void bm_calculate_normal_per_triangle(benchmark::State& state) {
+    std::vector<glm::vec3> normals(normals::block_size);
+
+    for (auto _ : state) {
+        for (auto const& block : blocks) {
+            auto const& c = block.corners;
+
+            for (size_t i = 0; i < normals::block_size; i++) {
+                normals[i] = utils::calculate_normal(
+                    glm::vec3(c[0][i], c[1][i], c[2][i]),
+                    glm::vec3(c[3][i], c[4][i], c[5][i]),
+                    glm::vec3(c[6][i], c[7][i], c[8][i])
+                );
+            }
+
+            benchmark::DoNotOptimize(normals.data());
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * blocks_count * normals::block_size));
+}
+
+static void bm_calculate_normals_blocks(benchmark::State& state) {
+    const auto isa = static_cast<normals::Isa>(state.range(0));
+
+    if (!normals::is_supported(isa)) {
+        state.SkipWithError("isa is not supported");
+        return;
+    }
+
+    normals::NormalBlock normals {};
+
+    for (auto _ : state) {
+        for (auto const& block : blocks) {
+            normals::calculate_normals(block, normals, isa);
+            benchmark::DoNotOptimize(normals.axes.data());
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * blocks_count * normals::block_size));
+}
+
+BENCHMARK(bm_calculate_normal_per_triangle);
+BENCHMARK(bm_calculate_normals_blocks)
+    ->Arg(int(normals::Isa::Scalar))
+    ->Arg(int(normals::Isa::Avx2))
+    ->Arg(int(normals::Isa::Avx512));
+
+BENCHMARK_MAIN();
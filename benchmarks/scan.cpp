@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include "scan.hpp"
+#include "utils.hpp"
+
+static const std::string complex_path = "../../tests/resources/complex.obj";
+
+static void bm_split_lines_complex(benchmark::State& state) {
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        const auto lines = utils::load_text_file_lines(complex_path);
+
+        for (auto const& line : lines) {
+            benchmark::DoNotOptimize(utils::split(line, ' '));
+            bytes += line.size() + 1;
+        }
+    }
+
+    state.SetBytesProcessed(int64_t(bytes));
+}
+
+static void bm_scan_lines_complex(benchmark::State& state) {
+    const auto isa = static_cast<scan::Isa>(state.range(0));
+
+    if (!scan::is_supported(isa)) {
+        state.SkipWithError("isa is not supported");
+        return;
+    }
+
+    const utils::MappedFile file(complex_path);
+    std::vector<uint32_t> delimiters;
+    std::string_view line;
+
+    for (auto _ : state) {
+        scan::LineScanner scanner(file.view(), isa);
+
+        while (scanner.next_line(line, delimiters)) {
+            benchmark::DoNotOptimize(delimiters.data());
+        }
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(file.size()));
+}
+
+BENCHMARK(bm_split_lines_complex);
+BENCHMARK(bm_scan_lines_complex)
+    ->Arg(int(scan::Isa::Scalar))
+    ->Arg(int(scan::Isa::Sse2))
+    ->Arg(int(scan::Isa::Avx2));
+
+BENCHMARK_MAIN();
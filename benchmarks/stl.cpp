@@ -1,14 +1,14 @@
 #include <benchmark/benchmark.h>
+#include <filesystem>
 
 #include "obj.hpp"
 #include "stl.hpp"
 #include "utils.hpp"
 #include "calc.hpp"
+#include "convert.hpp"
 
 std::shared_ptr<mesh::MeshLayout> load_layout(std::string const& file_name) {
-    auto lines = utils::load_text_file_lines("../../tests/resources/" + file_name);
-    auto obj = obj_file::load_from_string_lines(lines);
-    return obj_file::create_mesh_layout_from_obj(obj);
+    return obj_file::load_mesh_layout_from_file("../../tests/resources/" + file_name);
 }
 
 static auto box = load_layout("box.obj");
@@ -29,6 +29,18 @@ void apply_transforms(std::shared_ptr<mesh::MeshLayout> const& layout) {
     );
 }
 
+// Memory held by the face table of the layout, depends on the index width of the build
+// and on which channels are stored
+static double face_table_bytes(mesh::FaceTable const& faces) {
+    const auto indices = faces.offsets.size() +
+        faces.vertices_indices.size() +
+        faces.normals_indices.size() +
+        faces.tex_coord_indices.size() +
+        faces.color_indices.size();
+
+    return double(indices * sizeof(mesh::index_t));
+}
+
 static void bm_load_layout_box(benchmark::State& state) {
     for (auto _ : state) {
         load_layout("box.obj");
@@ -39,12 +51,63 @@ static void bm_load_layout_complex(benchmark::State& state) {
     for (auto _ : state) {
         load_layout("complex.obj");
     }
+
+    state.counters["face_bytes"] = face_table_bytes(complex->faces());
 }
 
 static void bm_load_layout_bugatti(benchmark::State& state) {
     for (auto _ : state) {
         load_layout("bugatti.obj");
     }
+
+    state.counters["face_bytes"] = face_table_bytes(bugatti->faces());
+}
+
+// Fetches the vertex of every face corner through an index column of the given width,
+// the access pattern of MeshLayoutReader, so both widths are measured in one build
+template<typename Index>
+static void bm_gather_vertices(benchmark::State& state, std::shared_ptr<mesh::MeshLayout> const& layout) {
+    const std::vector<Index> indices(layout->faces().vertices_indices.begin(), layout->faces().vertices_indices.end());
+
+    for (auto _ : state) {
+        glm::vec3 sum(0);
+
+        for (const auto index : indices) {
+            sum += layout->vertices()[index];
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * indices.size()));
+    state.counters["index_bytes"] = double(indices.size() * sizeof(Index));
+}
+
+template<typename Index>
+static void bm_gather_vertices_complex(benchmark::State& state) {
+    bm_gather_vertices<Index>(state, complex);
+}
+
+template<typename Index>
+static void bm_gather_vertices_bugatti(benchmark::State& state) {
+    bm_gather_vertices<Index>(state, bugatti);
+}
+
+static void bm_load_layout_through_obj_struct_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        auto obj = obj_file::load_from_file("../../tests/resources/complex.obj");
+        benchmark::DoNotOptimize(obj_file::create_mesh_layout_from_obj(obj));
+    }
+}
+
+static void bm_parse_obj_complex(benchmark::State& state) {
+    const utils::MappedFile file("../../tests/resources/complex.obj");
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(obj_file::load_from_string(file.view(), state.range(0)));
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(file.size()));
 }
 
 static void bm_convert_to_stl_box(benchmark::State& state) {
@@ -65,6 +128,232 @@ static void bm_convert_to_stl_bugatti(benchmark::State& state) {
     }
 }
 
+// What main did for -c before sinks: the whole output in memory, then written to the file
+static void bm_convert_to_stl_file_in_memory_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        const auto bytes = stl_file::StlMeshWriter().write(complex);
+
+        std::ofstream outfile("bench_file.stl", std::ios::out | std::ios::binary);
+        outfile.write(bytes.data(), std::streamsize(bytes.size()));
+        outfile.close();
+
+        state.PauseTiming();
+        std::remove("bench_file.stl");
+        state.ResumeTiming();
+    }
+}
+
+static void bm_convert_to_stl_file_sink_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        mesh_format::FileSink sink("bench_file.stl");
+        stl_file::StlMeshWriter().write(complex, sink);
+        sink.close();
+
+        state.PauseTiming();
+        std::remove("bench_file.stl");
+        state.ResumeTiming();
+    }
+}
+
+// 2^18 quads, half a million triangles, 25 MB of stl
+static std::shared_ptr<mesh::MeshLayout> quads_layout() {
+    std::vector<glm::vec3> vertices;
+    mesh::FaceTable faces;
+
+    for (size_t face = 0; face < (1 << 18); face++) {
+        const auto x = float(face % 512);
+        const auto y = float(face / 512);
+        const auto first = mesh::index_t(vertices.size());
+
+        vertices.emplace_back(x, y, 0);
+        vertices.emplace_back(x + 1, y, 0.5f);
+        vertices.emplace_back(x + 1, y + 1, 0.5f);
+        vertices.emplace_back(x, y + 1, 0);
+
+        for (mesh::index_t i = 0; i < 4; i++) {
+            faces.push_index(first + i, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+        }
+
+        faces.end_face();
+    }
+
+    return std::make_shared<mesh::MeshLayout>(
+        std::move(vertices),
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+}
+
+static void bm_convert_to_stl_file_threads(benchmark::State& state) {
+    const auto layout = quads_layout();
+    const auto threads = size_t(state.range(0));
+    stl_file::StlMeshWriter writer(std::make_shared<mesh::FanTriangulationStrategy>(), threads);
+
+    for (auto _ : state) {
+        mesh_format::FileSink sink("bench_file.stl");
+        writer.write(layout, sink);
+        sink.close();
+
+        state.PauseTiming();
+        std::remove("bench_file.stl");
+        state.ResumeTiming();
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(84 + 50 * 2 * layout->faces().size()));
+    state.counters["triangles"] = benchmark::Counter(
+        double(state.iterations() * 2 * layout->faces().size()),
+        benchmark::Counter::kIsRate
+    );
+}
+
+static void bm_convert_to_stl_text_file_threads(benchmark::State& state) {
+    const auto layout = quads_layout();
+    const auto threads = size_t(state.range(0));
+    stl_file::StlTextMeshWriter writer(std::make_shared<mesh::FanTriangulationStrategy>(), threads);
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        mesh_format::FileSink sink("bench_file.stl");
+        writer.write(layout, sink);
+        sink.close();
+
+        state.PauseTiming();
+        bytes += std::filesystem::file_size("bench_file.stl");
+        std::remove("bench_file.stl");
+        state.ResumeTiming();
+    }
+
+    state.SetBytesProcessed(int64_t(bytes));
+    state.counters["triangles"] = benchmark::Counter(
+        double(state.iterations() * 2 * layout->faces().size()),
+        benchmark::Counter::kIsRate
+    );
+}
+
+// Binary stl through the per triangle virtual api of MeshWriter, like the writer before the block dispatch
+class PerTriangleStlWriter : public mesh_format::MeshWriter {
+public:
+    PerTriangleStlWriter() : MeshWriter(mesh_format::FileType::Binary, mesh_format::ByteOrder::LittleEndian) {}
+
+private:
+    void write_layout() override {
+        const std::vector<std::byte> header(80);
+
+        this->writer->write_bytes(header);
+        this->writer->write_int32_t(static_cast<int32_t>(this->layout_reader->triangles_count()));
+        this->write_triangles();
+    }
+
+    void write_triangle(mesh::Triangle const& triangle) override {
+        auto const& v = triangle.vertices();
+        const auto normal = utils::calculate_normal(v[0], v[1], v[2]);
+        const float values[] = {
+            normal.x, normal.y, normal.z,
+            v[0].x, v[0].y, v[0].z,
+            v[1].x, v[1].y, v[1].z,
+            v[2].x, v[2].y, v[2].z,
+        };
+
+        this->writer->write_record(values, 12, 2);
+    }
+};
+
+template<typename Writer>
+static void bm_write_stl_dispatch(benchmark::State& state) {
+    const auto layout = quads_layout();
+    Writer writer;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writer.write(layout));
+    }
+
+    state.counters["triangles"] = benchmark::Counter(
+        double(state.iterations() * 2 * layout->faces().size()),
+        benchmark::Counter::kIsRate
+    );
+}
+
+// complex.obj written as binary stl once, read back by the benchmarks below
+static const std::string complex_stl_path = [] {
+    mesh_format::FileSink sink("bench_complex.stl");
+    stl_file::StlMeshWriter().write(complex, sink);
+    sink.close();
+
+    return std::string("bench_complex.stl");
+}();
+
+static void bm_read_stl_surface_area_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        const stl_file::StlTriangleView triangles(complex_stl_path);
+        benchmark::DoNotOptimize(calc::calculate_surface_area(triangles));
+    }
+}
+
+static void bm_read_stl_build_layout_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        const stl_file::StlTriangleView triangles(complex_stl_path);
+        benchmark::DoNotOptimize(triangles.build_layout());
+    }
+}
+
+// Two triangles per quad of a size x size grid, every corner its own vertex like in stl
+static std::shared_ptr<mesh::MeshLayout> grid_soup(size_t size) {
+    std::vector<glm::vec3> vertices;
+    mesh::FaceTable faces;
+
+    vertices.reserve(6 * size * size);
+    faces.reserve(2 * size * size, 6 * size * size);
+
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            const glm::vec3 a(x, y, 0), b(x + 1, y, 0), c(x + 1, y + 1, 0), d(x, y + 1, 0);
+
+            for (auto const& vertex : {a, b, c, a, c, d}) {
+                faces.push_index(mesh::index_t(vertices.size()), mesh::absent_index, mesh::absent_index, mesh::absent_index);
+                vertices.push_back(vertex);
+
+                if (vertices.size() % 3 == 0) {
+                    faces.end_face();
+                }
+            }
+        }
+    }
+
+    return std::make_shared<mesh::MeshLayout>(
+        std::move(vertices),
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+}
+
+// Args are the grid size and threads
+static void bm_weld_vertices_soup(benchmark::State& state) {
+    const auto soup = grid_soup(size_t(state.range(0)));
+    size_t welded_count = 0;
+
+    for (auto _ : state) {
+        welded_count = calc::weld_vertices(soup, 0, size_t(state.range(1)))->vertices().size();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * soup->vertices().size()));
+    state.counters["triangles"] = double(soup->faces().size());
+    state.counters["reduction"] = double(soup->vertices().size()) / double(welded_count);
+}
+
+static void bm_stream_to_stl_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        convert::stream_obj_to_stl("../../tests/resources/complex.obj", "bench_stream.stl", glm::mat4(1));
+
+        state.PauseTiming();
+        std::remove("bench_stream.stl");
+        state.ResumeTiming();
+    }
+}
+
 static void bm_apply_transforms_box(benchmark::State& state) {
     for (auto _ : state) {
         apply_transforms(box);
@@ -83,6 +372,23 @@ static void bm_apply_transforms_bugatti(benchmark::State& state) {
     }
 }
 
+static void bm_apply_transforms_threads(benchmark::State& state) {
+    const auto layout = quads_layout();
+    const auto threads = size_t(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calc::apply_transforms_to_layout(
+            layout,
+            glm::vec3(123, 93, 56),
+            glm::vec3(34, 91, 43),
+            glm::vec3(12, 33, 10),
+            threads
+        ));
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(layout->vertices().size() * sizeof(glm::vec3)));
+}
+
 static void bm_calculate_surface_area_box(benchmark::State& state) {
     for (auto _ : state) {
         calc::calculate_surface_area(box);
@@ -137,17 +443,74 @@ static void bm_is_point_inside_mesh_bugatti(benchmark::State& state) {
     }
 }
 
+// What main runs for -s -v -p, the first calculation triangulates the layout for the others
+static void run_calculations(std::shared_ptr<mesh::MeshLayout> const& layout) {
+    benchmark::DoNotOptimize(calc::calculate_surface_area(layout));
+    benchmark::DoNotOptimize(calc::calculate_volume(layout));
+    benchmark::DoNotOptimize(calc::is_point_inside_mesh(glm::vec3(12, 11, 0), layout));
+}
+
+static void bm_all_calculations_cold_complex(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto layout = calc::apply_transforms_to_layout(complex, glm::vec3(0), glm::vec3(0), glm::vec3(1));
+        state.ResumeTiming();
+
+        run_calculations(layout);
+    }
+}
+
+static void bm_all_calculations_warm_complex(benchmark::State& state) {
+    run_calculations(complex);
+
+    for (auto _ : state) {
+        run_calculations(complex);
+    }
+}
+
 BENCHMARK(bm_load_layout_box);
 BENCHMARK(bm_load_layout_complex);
 BENCHMARK(bm_load_layout_bugatti);
+BENCHMARK(bm_load_layout_through_obj_struct_complex);
+
+BENCHMARK_TEMPLATE(bm_gather_vertices_complex, uint32_t);
+BENCHMARK_TEMPLATE(bm_gather_vertices_complex, uint64_t);
+BENCHMARK_TEMPLATE(bm_gather_vertices_bugatti, uint32_t);
+BENCHMARK_TEMPLATE(bm_gather_vertices_bugatti, uint64_t);
+
+BENCHMARK(bm_parse_obj_complex)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
 
 BENCHMARK(bm_convert_to_stl_box);
 BENCHMARK(bm_convert_to_stl_complex);
 BENCHMARK(bm_convert_to_stl_bugatti);
 
+BENCHMARK(bm_convert_to_stl_file_in_memory_complex);
+BENCHMARK(bm_convert_to_stl_file_sink_complex);
+BENCHMARK(bm_convert_to_stl_file_threads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK(bm_convert_to_stl_text_file_threads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_TEMPLATE(bm_write_stl_dispatch, PerTriangleStlWriter);
+BENCHMARK_TEMPLATE(bm_write_stl_dispatch, stl_file::StlMeshWriter);
+
+BENCHMARK(bm_stream_to_stl_complex);
+
+BENCHMARK(bm_read_stl_surface_area_complex);
+BENCHMARK(bm_read_stl_build_layout_complex);
+
+// 1M and 10M triangles
+BENCHMARK(bm_weld_vertices_soup)
+    ->Args({708, 1})
+    ->Args({2237, 1})
+    ->Args({2237, 2})
+    ->Args({2237, 4})
+    ->Args({2237, 8})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 BENCHMARK(bm_apply_transforms_box);
 BENCHMARK(bm_apply_transforms_complex);
 BENCHMARK(bm_apply_transforms_bugatti);
+BENCHMARK(bm_apply_transforms_threads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
 
 BENCHMARK(bm_calculate_surface_area_box);
 BENCHMARK(bm_calculate_surface_area_complex);
@@ -161,5 +524,8 @@ BENCHMARK(bm_is_point_inside_mesh_box);
 BENCHMARK(bm_is_point_inside_mesh_complex);
 BENCHMARK(bm_is_point_inside_mesh_bugatti);
 
+BENCHMARK(bm_all_calculations_cold_complex);
+BENCHMARK(bm_all_calculations_warm_complex);
+
 
 BENCHMARK_MAIN();
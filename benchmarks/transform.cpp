@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <random>
+
+#include "transform.hpp"
+#include "calc.hpp"
+
+// A million vertices, past the caches like the vertices of a large mesh
+static const std::vector<glm::vec3> points = [] {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+    std::vector<glm::vec3> points(1 << 20);
+
+    for (auto& point : points) {
+        point = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+    }
+
+    return points;
+}();
+
+static const auto model_matrix = calc::create_transform_matrix(
+    glm::vec3(123, 93, 56),
+    glm::vec3(34, 91, 43),
+    glm::vec3(12, 33, 10)
+);
+
+// Per vertex glm product, like apply_transforms_to_layout before the kernel
+static void bm_transform_points_glm(benchmark::State& state) {
+    std::vector<glm::vec3> output(points.size());
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < points.size(); i++) {
+            output[i] = glm::vec3(model_matrix * glm::vec4(points[i], 1.0f));
+        }
+
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * points.size()));
+}
+
+static void bm_transform_points(benchmark::State& state) {
+    const auto isa = static_cast<transform::Isa>(state.range(0));
+
+    if (!transform::is_supported(isa)) {
+        state.SkipWithError("isa is not supported");
+        return;
+    }
+
+    const auto matrix = transform::get_point_matrix(model_matrix);
+    std::vector<glm::vec3> output(points.size());
+
+    for (auto _ : state) {
+        transform::transform_points(points.data(), output.data(), points.size(), matrix, isa);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * points.size()));
+}
+
+static void bm_transform_normals(benchmark::State& state) {
+    const auto isa = static_cast<transform::Isa>(state.range(0));
+
+    if (!transform::is_supported(isa)) {
+        state.SkipWithError("isa is not supported");
+        return;
+    }
+
+    const auto matrix = transform::get_normal_matrix(model_matrix);
+    std::vector<glm::vec3> output(points.size());
+
+    for (auto _ : state) {
+        transform::transform_normals(points.data(), output.data(), points.size(), matrix, isa);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * points.size()));
+}
+
+BENCHMARK(bm_transform_points_glm);
+BENCHMARK(bm_transform_points)
+    ->Arg(int(transform::Isa::Scalar))
+    ->Arg(int(transform::Isa::Avx2));
+BENCHMARK(bm_transform_normals)
+    ->Arg(int(transform::Isa::Scalar))
+    ->Arg(int(transform::Isa::Avx2));
+
+BENCHMARK_MAIN();
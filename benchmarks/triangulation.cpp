@@ -0,0 +1,158 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+#include "mesh.hpp"
+
+// Regular n-gon with normals and tex coords, the arity is the benchmark argument
+static mesh::Polygon regular_polygon(size_t corners_count) {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> tex_coords;
+
+    for (size_t i = 0; i < corners_count; i++) {
+        const auto angle = 2.0f * 3.14159265f * float(i) / float(corners_count);
+
+        vertices.emplace_back(std::cos(angle), std::sin(angle), 0);
+        normals.emplace_back(0, 0, 1);
+        tex_coords.emplace_back(float(i), 0);
+    }
+
+    return mesh::Polygon(vertices, normals, tex_coords);
+}
+
+// Star with every other corner pulled in, concave at all of them, the arity is the benchmark argument
+static mesh::Polygon star_polygon(size_t corners_count) {
+    std::vector<glm::vec3> vertices;
+
+    for (size_t i = 0; i < corners_count; i++) {
+        const auto angle = 2.0 * 3.14159265358979 * double(i) / double(corners_count);
+        const auto radius = i % 2 == 0 ? 1.0 : 0.4;
+
+        vertices.emplace_back(float(radius * std::cos(angle)), float(radius * std::sin(angle)), 0);
+    }
+
+    return mesh::Polygon(vertices, std::nullopt, std::nullopt, std::nullopt);
+}
+
+// 2^16 corners by default split into faces of the same arity, every face is the regular polygon
+static std::shared_ptr<mesh::MeshLayout> uniform_layout(size_t corners_count, size_t total_corners_count = 1 << 16) {
+    const size_t faces_count = total_corners_count / corners_count;
+
+    mesh::FaceTable faces;
+    faces.reserve(faces_count, faces_count * corners_count);
+
+    for (size_t face = 0; face < faces_count; face++) {
+        for (size_t i = 0; i < corners_count; i++) {
+            faces.push_index(mesh::index_t(i), mesh::absent_index, mesh::absent_index, mesh::absent_index);
+        }
+
+        faces.end_face();
+    }
+
+    return std::make_shared<mesh::MeshLayout>(
+        regular_polygon(corners_count).vertices(),
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+}
+
+template<typename Strategy>
+static void bm_triangulate_polygon(benchmark::State& state) {
+    const auto polygon = regular_polygon(size_t(state.range(0)));
+    Strategy triangulation_strategy;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(triangulation_strategy.triangulate(polygon));
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * (state.range(0) - 2));
+}
+
+// Output vector is reused, the way the streaming converter triangulates
+template<typename Strategy>
+static void bm_triangulate_polygon_into(benchmark::State& state) {
+    const auto polygon = regular_polygon(size_t(state.range(0)));
+    Strategy triangulation_strategy;
+    std::vector<mesh::Triangle> triangles;
+
+    for (auto _ : state) {
+        triangles.clear();
+        triangulation_strategy.triangulate_into(polygon, triangles);
+        benchmark::DoNotOptimize(triangles.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * (state.range(0) - 2));
+}
+
+template<typename Strategy>
+static void bm_triangulate_faces(benchmark::State& state) {
+    const auto layout = uniform_layout(size_t(state.range(0)));
+    Strategy triangulation_strategy;
+    std::vector<mesh::index_t> corners;
+
+    for (auto _ : state) {
+        corners.clear();
+
+        for (size_t face = 0; face < layout->faces().size(); face++) {
+            triangulation_strategy.triangulate_face(*layout, face, corners);
+        }
+
+        benchmark::DoNotOptimize(corners.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(corners.size() / 3));
+}
+
+// Layout of 2^18 quads triangulated from scratch every iteration, threads are the benchmark argument
+template<typename Strategy>
+static void bm_triangulate_layout_threads(benchmark::State& state) {
+    Strategy triangulation_strategy;
+    size_t triangles_count = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto layout = uniform_layout(4, 1 << 20);
+        state.ResumeTiming();
+
+        triangles_count += layout->triangulation(triangulation_strategy, size_t(state.range(0)))->size();
+    }
+
+    state.SetItemsProcessed(int64_t(triangles_count));
+}
+
+// Fan output is wrong for these, it's the baseline cost of a triangulation at all
+template<typename Strategy>
+static void bm_triangulate_concave(benchmark::State& state) {
+    const auto polygon = star_polygon(size_t(state.range(0)));
+    Strategy triangulation_strategy;
+    std::vector<mesh::Triangle> triangles;
+
+    for (auto _ : state) {
+        triangles.clear();
+        triangulation_strategy.triangulate_into(polygon, triangles);
+        benchmark::DoNotOptimize(triangles.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * (state.range(0) - 2));
+}
+
+BENCHMARK_TEMPLATE(bm_triangulate_polygon, mesh::DummyTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(bm_triangulate_polygon, mesh::FanTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(bm_triangulate_polygon_into, mesh::FanTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64)->Arg(1024);
+
+BENCHMARK_TEMPLATE(bm_triangulate_faces, mesh::DummyTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64);
+BENCHMARK_TEMPLATE(bm_triangulate_faces, mesh::FanTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64);
+
+BENCHMARK_TEMPLATE(bm_triangulate_polygon, mesh::EarClippingTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(bm_triangulate_faces, mesh::EarClippingTriangulationStrategy)->Arg(3)->Arg(4)->Arg(5)->Arg(8)->Arg(64);
+
+BENCHMARK_TEMPLATE(bm_triangulate_concave, mesh::FanTriangulationStrategy)->RangeMultiplier(4)->Range(16, 1 << 17);
+BENCHMARK_TEMPLATE(bm_triangulate_concave, mesh::EarClippingTriangulationStrategy)->RangeMultiplier(4)->Range(16, 1 << 17);
+
+BENCHMARK_TEMPLATE(bm_triangulate_layout_threads, mesh::FanTriangulationStrategy)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_triangulate_layout_threads, mesh::EarClippingTriangulationStrategy)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -6,21 +6,73 @@
 #include <memory>
 
 #include "mesh.hpp"
+#include "stl.hpp"
 
 namespace calc {
 
-    // Create new transformed mesh layout
+    // Model matrix for translation, rotation (radians) and scale
+    glm::mat4 create_transform_matrix(glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale);
+
+    // Create new transformed mesh layout, the identity transform returns the source layout itself.
+    // Vertices are transformed on threads, normals by the inverse transpose and normalized,
+    // the faces, tex coords and colors arrays and the triangulation cache are shared with the source layout
     std::shared_ptr<mesh::MeshLayout> apply_transforms_to_layout(
         std::shared_ptr<mesh::MeshLayout> const& layout,
         glm::vec3 pos,
         glm::vec3 rotation,
-        glm::vec3 scale
+        glm::vec3 scale,
+        size_t threads = 1
     );
 
+    // New layout where vertices at the same position share one vertex, faces are reindexed to them and
+    // the other arrays are kept. With grid_size > 0 positions are snapped to a grid of grid_size cells
+    // and the vertices of a cell are welded, faces collapsed by that stay degenerate. It's quantization,
+    // not welding by distance: close vertices on both sides of a cell boundary stay apart.
+    // Welded vertices keep the order of their first occurrences, the result doesn't depend on threads
+    std::shared_ptr<mesh::MeshLayout> weld_vertices(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        float grid_size = 0,
+        size_t threads = 1
+    );
+
+    // Same welding in place of arrays the caller owns: vertices become the welded ones and the vertices
+    // column of faces is reindexed to them, the face table isn't copied
+    void weld_vertices(std::vector<glm::vec3>& vertices, mesh::FaceTable& faces, float grid_size = 0, size_t threads = 1);
+
+    // Calculations triangulate the layout with a fan unless a strategy is given,
+    // threads only speed up the triangulation of a layout that isn't triangulated yet
+
     double calculate_surface_area(std::shared_ptr<mesh::MeshLayout> const& layout);
 
+    double calculate_surface_area(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads = 1
+    );
+
     double calculate_volume(std::shared_ptr<mesh::MeshLayout> const& layout);
 
+    double calculate_volume(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads = 1
+    );
+
     bool is_point_inside_mesh(glm::vec3 point, std::shared_ptr<mesh::MeshLayout> const& layout);
 
+    bool is_point_inside_mesh(
+        glm::vec3 point,
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads = 1
+    );
+
+    // Same calculations over the triangles of an stl file as they are stored
+
+    double calculate_surface_area(stl_file::StlTriangleView const& triangles);
+
+    double calculate_volume(stl_file::StlTriangleView const& triangles);
+
+    bool is_point_inside_mesh(glm::vec3 point, stl_file::StlTriangleView const& triangles);
+
 }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+namespace convert {
+
+    // Convert obj to binary stl in a single pass: faces are triangulated and written as
+    // soon as they are parsed, only the transformed vertices are kept in memory
+    void stream_obj_to_stl(std::string const& input, std::string const& output, glm::mat4 const& transform);
+
+    void stream_obj_to_stl(
+        std::string const& input,
+        std::string const& output,
+        glm::mat4 const& transform,
+        mesh::TriangulationStrategy& triangulation_strategy
+    );
+
+}
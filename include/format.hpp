@@ -1,6 +1,11 @@
 #pragma one
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+
 #include "mesh.hpp"
 
 namespace mesh_format {
@@ -21,11 +26,13 @@ namespace mesh_format {
         BytesWriter(FileType file_type, ByteOrder byte_order) {
             this->file_type = file_type;
             this->byte_order = byte_order;
+            this->endian_mismatch = this->is_endian_mismatch();
         }
 
         explicit BytesWriter(FileType file_type) {
             this->file_type = file_type;
             this->byte_order = ByteOrder::Native;
+            this->endian_mismatch = this->is_endian_mismatch();
         }
 
         std::vector<std::byte> const& get_bytes();
@@ -34,16 +41,28 @@ namespace mesh_format {
 
         void clear();
 
+        // Capacity for size bytes, so writing up to them doesn't reallocate
+        void reserve(size_t size);
+
         void write_int32_t(int32_t value);
 
+        void write_uint32_t(uint32_t value);
+
         void write_float(float value);
 
+        void write_floats(const float* values, size_t count);
+
+        // Floats followed by padding zero bytes, appended at once
+        void write_record(const float* values, size_t count, size_t padding);
+
         void write_byte(std::byte byte);
 
         void write_bytes(std::vector<std::byte> const& in_bytes);
 
         void write_char(char ch);
 
+        void write_chars(const char* chars, size_t size);
+
         void write_string(std::string const& str);
 
     private:
@@ -53,20 +72,116 @@ namespace mesh_format {
         FileType file_type;
         ByteOrder byte_order;
 
+        // Resolved once, the values are either copied as is or byte swapped
+        bool endian_mismatch;
+
         bool is_endian_mismatch();
+
+        // Grows the bytes by size and returns the new ones
+        std::byte* append(size_t size);
+
+        void store_floats(std::byte* output, const float* values, size_t count) const;
+    };
+
+    // Bytes are passed to a sink in chunks of about this size
+    constexpr size_t sink_chunk_size = 1 << 20;
+
+    // Destination of written bytes, receives the output in order, chunk by chunk
+    class OutputSink {
+    public:
+        virtual ~OutputSink() = default;
+
+        virtual void write(const std::byte* data, size_t size) = 0;
+
+        // Appends size bytes to the output and returns them to be filled in place, they stay valid
+        // until the next call of the sink. Sinks that can't do it return nullptr
+        virtual std::byte* allocate(size_t /*size*/) { return nullptr; }
+    };
+
+    // Collects the whole output in memory
+    class MemorySink : public OutputSink {
+    public:
+        void write(const std::byte* data, size_t size) override;
+
+        std::byte* allocate(size_t size) override;
+
+        std::vector<char> release();
+
+    private:
+        std::vector<char> data;
+    };
+
+    // Writes to a file descriptor through a buffer, writes not smaller than the buffer go to the
+    // descriptor directly. Throws std::ofstream::failure on i/o errors
+    class FileSink : public OutputSink {
+    public:
+        explicit FileSink(std::string const& filepath, size_t buffer_size = sink_chunk_size);
+
+        FileSink(FileSink const&) = delete;
+
+        FileSink& operator=(FileSink const&) = delete;
+
+        // Closes the file if close wasn't called, errors are ignored
+        ~FileSink() override;
+
+        void write(const std::byte* data, size_t size) override;
+
+        // Reserves the space in the file and maps it
+        std::byte* allocate(size_t size) override;
+
+        // Flushes the buffer and closes the file
+        void close();
+
+    private:
+        std::string filepath;
+        int fd = -1;
+        size_t buffer_size;
+        std::vector<std::byte> buffer;
+        void* mapped = nullptr;
+        size_t mapped_length = 0;
+
+        void flush();
+
+        void unmap();
+
+        void write_to_file(const std::byte* data, size_t size);
     };
 
     class MeshWriter {
     public:
         std::vector<char> write(std::shared_ptr<mesh::MeshLayout> const& layout);
 
-        MeshWriter(FileType file_type, ByteOrder byte_order) {
+        // Only one chunk of the output is held in memory at a time
+        void write(std::shared_ptr<mesh::MeshLayout> const& layout, OutputSink& sink);
+
+        MeshWriter(FileType file_type, ByteOrder byte_order) :
+            MeshWriter(file_type, byte_order, std::make_shared<mesh::FanTriangulationStrategy>())
+        {
+            // Nothing
+        }
+
+        // Threads triangulate the layout, see MeshLayout::triangulation
+        MeshWriter(
+            FileType file_type,
+            ByteOrder byte_order,
+            std::shared_ptr<mesh::TriangulationStrategy> triangulation_strategy,
+            size_t threads = 1
+        ) :
+            triangulation_strategy(std::move(triangulation_strategy)),
+            threads(threads)
+        {
             this->writer = std::make_unique<BytesWriter>(file_type, byte_order);
         }
 
     protected:
         std::unique_ptr<BytesWriter> writer;
+        std::shared_ptr<mesh::TriangulationStrategy> triangulation_strategy;
+        size_t threads;
         std::unique_ptr<mesh::MeshLayoutReader> layout_reader;
+        OutputSink* sink = nullptr;
+
+        // Passes the written bytes to the sink once there is a chunk of them
+        void flush_to_sink(bool force = false);
 
         virtual void write_header() {}
 
@@ -109,4 +224,119 @@ namespace mesh_format {
         virtual void write_triplet(mesh::Triplet const& index) {}
     };
 
+    // Static dispatch for formats that encode elements a block at a time. The loops below pass contiguous blocks
+    // to the non-virtual write_*_block methods of Derived, so there is one call per block and the encoding loop
+    // inside it can be inlined and vectorized. Derived hides the block methods it supports, the others write nothing.
+    // The per element virtual methods are kept as adapters that write a block of one element
+    template<typename Derived>
+    class BatchMeshWriter : public MeshWriter {
+    public:
+        static constexpr size_t block_size = 64;
+
+        using MeshWriter::MeshWriter;
+
+    protected:
+        void write_triangle_block(const mesh::Triangle* /*triangles*/, size_t /*count*/) {}
+
+        void write_vertex_block(const glm::vec3* /*vertices*/, size_t /*count*/) {}
+
+        void write_normal_block(const glm::vec3* /*normals*/, size_t /*count*/) {}
+
+        void write_tex_coord_block(const glm::vec2* /*tex_coords*/, size_t /*count*/) {}
+
+        void write_triplet_block(const mesh::Triplet* /*triplets*/, size_t /*count*/) {}
+
+        // Triangles of the layout are made one at a time, they are gathered into blocks
+        void write_triangles() override {
+            std::vector<mesh::Triangle> block;
+            block.reserve(block_size);
+
+            this->layout_reader->for_each_triangle([this, &block](mesh::Triangle const& triangle) {
+                block.push_back(triangle);
+
+                if (block.size() == block_size) {
+                    this->derived().write_triangle_block(block.data(), block.size());
+                    block.clear();
+                    this->flush_to_sink();
+                }
+            });
+
+            if (!block.empty()) {
+                this->derived().write_triangle_block(block.data(), block.size());
+                this->flush_to_sink();
+            }
+        }
+
+        using MeshWriter::write_vertices;
+
+        using MeshWriter::write_normals;
+
+        using MeshWriter::write_tex_coords;
+
+        using MeshWriter::write_triplets;
+
+        void write_vertices(std::vector<glm::vec3> const& vertices) override {
+            this->write_blocks(vertices, [this](const glm::vec3* block, size_t count) {
+                this->derived().write_vertex_block(block, count);
+            });
+        }
+
+        void write_normals(std::vector<glm::vec3> const& normals) override {
+            this->write_blocks(normals, [this](const glm::vec3* block, size_t count) {
+                this->derived().write_normal_block(block, count);
+            });
+        }
+
+        void write_tex_coords(std::vector<glm::vec2> const& tex_coords) override {
+            this->write_blocks(tex_coords, [this](const glm::vec2* block, size_t count) {
+                this->derived().write_tex_coord_block(block, count);
+            });
+        }
+
+        void write_triplets(std::vector<mesh::Triplet> const& triplets) override {
+            this->write_blocks(triplets, [this](const mesh::Triplet* block, size_t count) {
+                this->derived().write_triplet_block(block, count);
+            });
+        }
+
+        void write_triangles(std::vector<mesh::Triangle> const& triangles) override {
+            this->write_blocks(triangles, [this](const mesh::Triangle* block, size_t count) {
+                this->derived().write_triangle_block(block, count);
+            });
+        }
+
+        void write_triangle(mesh::Triangle const& triangle) override {
+            this->derived().write_triangle_block(&triangle, 1);
+        }
+
+        void write_vertex(glm::vec3 const& vertex) override {
+            this->derived().write_vertex_block(&vertex, 1);
+        }
+
+        void write_normal(glm::vec3 const& normal) override {
+            this->derived().write_normal_block(&normal, 1);
+        }
+
+        void write_tex_coord(glm::vec2 const& tex_coord) override {
+            this->derived().write_tex_coord_block(&tex_coord, 1);
+        }
+
+        void write_triplet(mesh::Triplet const& triplet) override {
+            this->derived().write_triplet_block(&triplet, 1);
+        }
+
+    private:
+        Derived& derived() {
+            return static_cast<Derived&>(*this);
+        }
+
+        template<typename T, typename WriteBlock>
+        void write_blocks(std::vector<T> const& elements, WriteBlock const& write_block) {
+            for (size_t begin = 0; begin < elements.size(); begin += block_size) {
+                write_block(elements.data() + begin, std::min(block_size, elements.size() - begin));
+                this->flush_to_sink();
+            }
+        }
+    };
+
 }
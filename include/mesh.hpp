@@ -10,9 +10,25 @@
 #include <exception>
 #include <optional>
 #include <array>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <typeindex>
+#include <type_traits>
 
 namespace mesh {
-    const size_t absent_index = std::numeric_limits<size_t>::max();
+#ifdef MESH_INDEX_64
+    using index_t = uint64_t;
+#else
+    // Half the memory and cache traffic of 64-bit indices, enough for any mesh
+    // with less than 4G elements of a kind, build with ENABLE_64BIT_INDICES otherwise
+    using index_t = uint32_t;
+#endif
+
+    const index_t absent_index = std::numeric_limits<index_t>::max();
+
+    // Largest number of elements of a kind (or face corners) a layout can address
+    const size_t max_elements = absent_index;
 
     struct ValidationException : public std::exception {
         [[nodiscard]] const char* what() const noexcept override {
@@ -20,15 +36,24 @@ namespace mesh {
         }
     };
 
+    struct IndexOverflowException : public std::exception {
+        [[nodiscard]] const char* what() const noexcept override {
+            return "mesh is too large for the index type";
+        }
+    };
+
+    // Throws IndexOverflowException when count elements can't be addressed by index_t
+    void check_index_capacity(size_t count);
+
     struct Triplet {
-        size_t vertex_index;
-        size_t normal_index;
-        size_t tex_coord_index;
+        index_t vertex_index;
+        index_t normal_index;
+        index_t tex_coord_index;
 
         Triplet(
-            size_t vertex_index,
-            size_t normal_index,
-            size_t tex_coord_index
+            index_t vertex_index,
+            index_t normal_index,
+            index_t tex_coord_index
         ) {
             this->vertex_index = vertex_index;
             this->normal_index = normal_index;
@@ -53,71 +78,81 @@ namespace mesh {
         }
     };
 
-    struct Polygon {
-        const std::vector<glm::vec3> vertices;
-        const std::optional<std::vector<glm::vec3>> normals;
-        const std::optional<std::vector<glm::vec2>> tex_coords;
-        const std::optional<std::vector<glm::vec3>> normal;
-
+    // Immutable through its accessors, but movable, so a polygon can be handed over without copying its vectors
+    class Polygon {
+    public:
         Polygon(
-            std::vector<glm::vec3> const& vertices,
-            std::optional<std::vector<glm::vec3>> const& normals,
-            std::optional<std::vector<glm::vec2>> const& tex_coords,
+            std::vector<glm::vec3> vertices,
+            std::optional<std::vector<glm::vec3>> normals,
+            std::optional<std::vector<glm::vec2>> tex_coords,
             std::optional<std::vector<glm::vec3>> normal
         ) :
-            normals(normals),
-            vertices(vertices),
-            tex_coords(tex_coords),
-            normal(std::move(normal))
+            vertices_data(std::move(vertices)),
+            normals_data(std::move(normals)),
+            tex_coords_data(std::move(tex_coords)),
+            normal_data(std::move(normal))
         {
             // IVARIANT: all vectors should have the same size
-            if (normals) {
-                assert(vertices.size() == normals.value().size());
+            if (this->normals_data) {
+                assert(this->vertices_data.size() == this->normals_data.value().size());
             }
 
-            if (tex_coords) {
-                assert(vertices.size() == tex_coords.value().size());
+            if (this->tex_coords_data) {
+                assert(this->vertices_data.size() == this->tex_coords_data.value().size());
             }
         }
 
         Polygon(
-            std::vector<glm::vec3> const& vertices,
-            std::vector<glm::vec3> const& normals,
-            std::vector<glm::vec2> const& tex_coords
+            std::vector<glm::vec3> vertices,
+            std::vector<glm::vec3> normals,
+            std::vector<glm::vec2> tex_coords
         ) :
-            normals(normals),
-            vertices({vertices}),
-            tex_coords({tex_coords}),
-            normal({})
+            vertices_data(std::move(vertices)),
+            normals_data(std::move(normals)),
+            tex_coords_data(std::move(tex_coords)),
+            normal_data({})
         {
             // IVARIANT: all vectors should have the same size
-            assert(vertices.size() == normals.size());
-            assert(vertices.size() == tex_coords.size());
+            assert(this->vertices_data.size() == this->normals_data.value().size());
+            assert(this->vertices_data.size() == this->tex_coords_data.value().size());
         }
 
+        [[nodiscard]] std::vector<glm::vec3> const& vertices() const { return this->vertices_data; }
+
+        [[nodiscard]] std::optional<std::vector<glm::vec3>> const& normals() const { return this->normals_data; }
+
+        [[nodiscard]] std::optional<std::vector<glm::vec2>> const& tex_coords() const { return this->tex_coords_data; }
+
+        [[nodiscard]] std::optional<std::vector<glm::vec3>> const& normal() const { return this->normal_data; }
+
+        // Gives the vertices back to the caller, so a buffer can be reused for the next polygon
+        [[nodiscard]] std::vector<glm::vec3> release_vertices() && { return std::move(this->vertices_data); }
+
         bool operator==(Polygon const& other) const {
-            return this->vertices == other.vertices &&
-                this->normals == other.normals &&
-                this->tex_coords == other.tex_coords;
+            return this->vertices_data == other.vertices_data &&
+                this->normals_data == other.normals_data &&
+                this->tex_coords_data == other.tex_coords_data;
         }
-    };
 
-    struct Triangle {
-        const std::array<glm::vec3, 3> vertices;
-        const std::optional<std::array<glm::vec3, 3>> normals;
-        const std::optional<std::array<glm::vec2, 3>> tex_coords;
-        const std::optional<glm::vec3> normal;
+    private:
+        std::vector<glm::vec3> vertices_data;
+        std::optional<std::vector<glm::vec3>> normals_data;
+        std::optional<std::vector<glm::vec2>> tex_coords_data;
+        std::optional<std::vector<glm::vec3>> normal_data;
+    };
 
+    class Triangle {
+    public:
         Triangle(
             std::array<glm::vec3, 3> const& vertices,
             std::optional<std::array<glm::vec3, 3>> const& normals,
             std::optional<std::array<glm::vec2, 3>> const& tex_coords,
             std::optional<glm::vec3> normal
         ) :
-            normals(normals),
-            vertices(vertices),
-            tex_coords(tex_coords),
-            normal(normal)
+            vertices_data(vertices),
+            normals_data(normals),
+            tex_coords_data(tex_coords),
+            normal_data(normal)
         {
         }
 
@@ -126,67 +161,375 @@ namespace mesh {
             std::array<glm::vec3, 3> const& normals,
             std::array<glm::vec2, 3> const& tex_coords
         ) :
-            normals({normals}),
-            vertices(vertices),
-            tex_coords({tex_coords}),
-            normal({})
+            vertices_data(vertices),
+            normals_data({normals}),
+            tex_coords_data({tex_coords}),
+            normal_data({})
         {
         }
 
+        [[nodiscard]] std::array<glm::vec3, 3> const& vertices() const { return this->vertices_data; }
+
+        [[nodiscard]] std::optional<std::array<glm::vec3, 3>> const& normals() const { return this->normals_data; }
+
+        [[nodiscard]] std::optional<std::array<glm::vec2, 3>> const& tex_coords() const { return this->tex_coords_data; }
+
+        [[nodiscard]] std::optional<glm::vec3> const& normal() const { return this->normal_data; }
+
         bool operator==(Triangle const& other) const {
-            return this->vertices == other.vertices &&
-                this->normals == other.normals &&
-                this->tex_coords == other.tex_coords &&
-                this->normal == other.normal;
+            return this->vertices_data == other.vertices_data &&
+                this->normals_data == other.normals_data &&
+                this->tex_coords_data == other.tex_coords_data &&
+                this->normal_data == other.normal_data;
         }
+
+    private:
+        std::array<glm::vec3, 3> vertices_data;
+        std::optional<std::array<glm::vec3, 3>> normals_data;
+        std::optional<std::array<glm::vec2, 3>> tex_coords_data;
+        std::optional<glm::vec3> normal_data;
     };
 
-    struct FaceLayout {
-        const std::vector<size_t> vertices_indices;
-        const std::vector<size_t> normals_indices;
-        const std::vector<size_t> tex_coord_indices;
-        const std::vector<size_t> color_indices;
-
-        FaceLayout(
-            std::vector<size_t> const& vertices_indices,
-            std::vector<size_t> const& normals_indices,
-            std::vector<size_t> const& tex_coord_indices,
-            std::vector<size_t> const& color_indices
-        ) :
-            vertices_indices(vertices_indices),
-            normals_indices(normals_indices),
-            tex_coord_indices(tex_coord_indices),
-            color_indices(color_indices)
-        {
-            // IVARIANT: all vectors should have the same size
-            assert(vertices_indices.size() == normals_indices.size());
-            assert(vertices_indices.size() == tex_coord_indices.size());
-            assert(vertices_indices.size() == color_indices.size());
+    // Read-only view of a contiguous run of indices
+    class IndexRange {
+    public:
+        using value_type = index_t;
+        using const_iterator = const index_t*;
+        using iterator = const_iterator;
+
+        IndexRange(const index_t* first, const index_t* last) : first(first), last(last) {}
+
+        [[nodiscard]] const_iterator begin() const { return this->first; }
+
+        [[nodiscard]] const_iterator end() const { return this->last; }
+
+        [[nodiscard]] size_t size() const { return size_t(this->last - this->first); }
+
+        [[nodiscard]] bool empty() const { return this->first == this->last; }
+
+        index_t operator[](size_t index) const { return this->first[index]; }
+
+    private:
+        const index_t* first;
+        const index_t* last;
+    };
+
+    struct FaceView {
+        const IndexRange vertices_indices;
+        const IndexRange normals_indices;
+        const IndexRange tex_coord_indices;
+        const IndexRange color_indices;
+
+        [[nodiscard]] size_t size() const {
+            return this->vertices_indices.size();
         }
     };
 
-    struct MeshLayout {
-        const std::vector<glm::vec3> vertices;
-        const std::vector<glm::vec3> normals;
-        const std::vector<glm::vec2> tex_coords;
-        const std::vector<glm::vec4> colors;
-        const std::vector<FaceLayout> faces;
+    // Faces in compressed sparse row form: face i owns the indices [offsets[i], offsets[i + 1])
+    // of every column, so the whole table is five allocations regardless of the faces count.
+    // A normals, tex coords or colors column where every index is absent isn't stored at all:
+    // it stays empty until the first present index, which fills the preceding corners with absent_index
+    class FaceTable {
+    public:
+        // offsets.size() == size() + 1, offsets.front() == 0, offsets.back() == indices count
+        std::vector<index_t> offsets;
+        std::vector<index_t> vertices_indices;
+        std::vector<index_t> normals_indices;
+        std::vector<index_t> tex_coord_indices;
+        std::vector<index_t> color_indices;
+
+        class const_iterator {
+        public:
+            const_iterator(FaceTable const* table, size_t index) : table(table), index(index) {}
+
+            FaceView operator*() const { return (*this->table)[this->index]; }
+
+            const_iterator& operator++() {
+                this->index += 1;
+                return *this;
+            }
+
+            bool operator!=(const_iterator const& other) const { return this->index != other.index; }
+
+        private:
+            FaceTable const* table;
+            size_t index;
+        };
+
+        FaceTable() : offsets({0}) {}
+
+        [[nodiscard]] size_t size() const { return this->offsets.size() - 1; }
+
+        [[nodiscard]] bool empty() const { return this->size() == 0; }
+
+        [[nodiscard]] size_t indices_count() const { return this->vertices_indices.size(); }
+
+        [[nodiscard]] bool has_normals() const { return !this->normals_indices.empty(); }
+
+        [[nodiscard]] bool has_tex_coords() const { return !this->tex_coord_indices.empty(); }
+
+        [[nodiscard]] bool has_colors() const { return !this->color_indices.empty(); }
+
+        [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+
+        [[nodiscard]] const_iterator end() const { return const_iterator(this, this->size()); }
+
+        FaceView operator[](size_t index) const {
+            const auto first = this->offsets[index];
+            const auto last = this->offsets[index + 1];
+
+            return FaceView {
+                get_range(this->vertices_indices, first, last),
+                get_range(this->normals_indices, first, last),
+                get_range(this->tex_coord_indices, first, last),
+                get_range(this->color_indices, first, last)
+            };
+        }
+
+        void reserve(size_t faces, size_t indices);
+
+        // Appends one corner to the face being built, end_face() closes it
+        void push_index(index_t vertex_index, index_t normal_index, index_t tex_coord_index, index_t color_index) {
+            this->vertices_indices.push_back(vertex_index);
+            this->push_channel_index(this->normals_indices, normal_index);
+            this->push_channel_index(this->tex_coord_indices, tex_coord_index);
+            this->push_channel_index(this->color_indices, color_index);
+        }
+
+        void end_face() {
+            this->offsets.push_back(index_t(this->vertices_indices.size()));
+        }
+
+        void push_face(FaceView const& face);
+
+        void push_faces(FaceTable const& faces);
+
+    private:
+        // An absent channel is an empty range, so its faces read as having no indices of that kind
+        static IndexRange get_range(std::vector<index_t> const& column, size_t first, size_t last) {
+            if (column.empty()) {
+                return IndexRange(nullptr, nullptr);
+            }
+
+            return IndexRange(column.data() + first, column.data() + last);
+        }
+
+        // Called after the vertex index of the corner is pushed
+        void push_channel_index(std::vector<index_t>& column, index_t index) {
+            if (column.empty()) {
+                if (index == absent_index) {
+                    return;
+                }
+
+                this->materialize_channel(column, this->vertices_indices.size() - 1);
+            }
+
+            column.push_back(index);
+        }
+
+        // Starts storing an absent channel, the first count corners get absent indices
+        void materialize_channel(std::vector<index_t>& column, size_t count) const;
+
+        void append_channel(std::vector<index_t>& column, IndexRange const& range, size_t count);
+    };
+
+    class MeshLayout;
+
+    class TriangulationStrategy;
+
+    // Triangulation of a face table as positions of the triangle corners in its index columns
+    class TriangleIndexBuffer {
+    public:
+        static constexpr uint8_t normals_channel = 1;
+        static constexpr uint8_t tex_coords_channel = 2;
+
+        // Three per triangle
+        std::vector<index_t> corners;
+
+        // Per triangle, the channels every corner of its face has, like a polygon a face
+        // with some normals or tex coords missing has none of them
+        std::vector<uint8_t> channels;
+
+        [[nodiscard]] size_t size() const { return this->channels.size(); }
+
+        [[nodiscard]] Triangle get_triangle(MeshLayout const& layout, size_t index) const;
+    };
+
+    // Last triangulation of a face table, see MeshLayout::triangulation. Held by pointer so the layout stays movable
+    struct TriangulationCache {
+        std::mutex mutex;
+        std::shared_ptr<const TriangleIndexBuffer> data;
+        std::type_index strategy = typeid(void);
+
+        // Arrays the triangulation was made from, the vertices stay empty for a strategy that only looks at the faces
+        std::weak_ptr<const FaceTable> faces;
+        std::weak_ptr<const std::vector<glm::vec3>> vertices;
+    };
+
+    // Shared read-only by the readers and writers, the arrays are only reachable through const accessors.
+    // A layout derived from another one, like a transformed one, shares the arrays it doesn't change with it
+    class MeshLayout {
+    public:
+        template<typename T>
+        using SharedArray = std::shared_ptr<const std::vector<T>>;
 
         MeshLayout(
             std::vector<glm::vec3> vertices,
             std::vector<glm::vec3> normals,
             std::vector<glm::vec2> tex_coords,
             std::vector<glm::vec4> colors,
-            std::vector<FaceLayout> faces
+            FaceTable faces
+        ) :
+            MeshLayout(
+                std::make_shared<const std::vector<glm::vec3>>(std::move(vertices)),
+                std::make_shared<const std::vector<glm::vec3>>(std::move(normals)),
+                std::make_shared<const std::vector<glm::vec2>>(std::move(tex_coords)),
+                std::make_shared<const std::vector<glm::vec4>>(std::move(colors)),
+                std::make_shared<const FaceTable>(std::move(faces))
+            )
+        {
+            // Nothing
+        }
+
+        MeshLayout(
+            SharedArray<glm::vec3> vertices,
+            SharedArray<glm::vec3> normals,
+            SharedArray<glm::vec2> tex_coords,
+            SharedArray<glm::vec4> colors,
+            std::shared_ptr<const FaceTable> faces,
+            std::shared_ptr<TriangulationCache> triangulation_cache = nullptr
         ) :
-            vertices(std::move(vertices)),
-            normals(std::move(normals)),
-            tex_coords(std::move(tex_coords)),
-            colors(std::move(colors)),
-            faces(std::move(faces))
+            vertices_data(std::move(vertices)),
+            normals_data(std::move(normals)),
+            tex_coords_data(std::move(tex_coords)),
+            colors_data(std::move(colors)),
+            faces_data(std::move(faces)),
+            triangulation_cache(
+                triangulation_cache ? std::move(triangulation_cache) : std::make_shared<TriangulationCache>()
+            )
         {
             // Nothing
         }
+
+        [[nodiscard]] std::vector<glm::vec3> const& vertices() const { return *this->vertices_data; }
+
+        [[nodiscard]] std::vector<glm::vec3> const& normals() const { return *this->normals_data; }
+
+        [[nodiscard]] std::vector<glm::vec2> const& tex_coords() const { return *this->tex_coords_data; }
+
+        [[nodiscard]] std::vector<glm::vec4> const& colors() const { return *this->colors_data; }
+
+        [[nodiscard]] FaceTable const& faces() const { return *this->faces_data; }
+
+        // Same arrays, for a derived layout to share them instead of copying
+
+        [[nodiscard]] SharedArray<glm::vec3> const& shared_vertices() const { return this->vertices_data; }
+
+        [[nodiscard]] SharedArray<glm::vec3> const& shared_normals() const { return this->normals_data; }
+
+        [[nodiscard]] SharedArray<glm::vec2> const& shared_tex_coords() const { return this->tex_coords_data; }
+
+        [[nodiscard]] SharedArray<glm::vec4> const& shared_colors() const { return this->colors_data; }
+
+        [[nodiscard]] std::shared_ptr<const FaceTable> const& shared_faces() const { return this->faces_data; }
+
+        // A layout sharing the faces may share the cache too, then a strategy that doesn't look at
+        // the positions triangulates the faces once for both
+        [[nodiscard]] std::shared_ptr<TriangulationCache> const& shared_triangulation_cache() const {
+            return this->triangulation_cache;
+        }
+
+        // Triangulated once on the first call and shared by every consumer afterwards, safe to call
+        // from several threads. Asking with another kind of strategy, or with one that looks at the positions
+        // from a layout with other vertices, triangulates again and replaces the cache.
+        // With threads > 1 large layouts are triangulated on clones of the strategy concurrently,
+        // the triangles are the same and in the same order as on one thread
+        std::shared_ptr<const TriangleIndexBuffer> triangulation(TriangulationStrategy& strategy, size_t threads = 1) const;
+
+    private:
+        SharedArray<glm::vec3> vertices_data;
+        SharedArray<glm::vec3> normals_data;
+        SharedArray<glm::vec2> tex_coords_data;
+        SharedArray<glm::vec4> colors_data;
+        std::shared_ptr<const FaceTable> faces_data;
+        std::shared_ptr<TriangulationCache> triangulation_cache;
+    };
+
+    static_assert(std::is_nothrow_move_constructible_v<MeshLayout>, "layouts are passed around by move");
+    static_assert(std::is_nothrow_move_assignable_v<MeshLayout>, "layouts are passed around by move");
+
+    // Fan triangulation of the layout faces built on the fly: the triangles DummyTriangulationStrategy
+    // yields, in the same order, without materializing any polygon or triangle vector.
+    // Fan strategies are read through it, nothing proportional to the mesh size is allocated
+    class TriangleRange {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Triangle;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Triangle*;
+            using reference = Triangle;
+
+            const_iterator(MeshLayout const* layout, size_t face, size_t last_face);
+
+            Triangle operator*() const;
+
+            const_iterator& operator++();
+
+            bool operator==(const_iterator const& other) const {
+                return this->face == other.face && this->corner == other.corner;
+            }
+
+            bool operator!=(const_iterator const& other) const { return !(*this == other); }
+
+        private:
+            MeshLayout const* layout;
+            size_t face;
+            size_t last_face;
+
+            // Current triangle is the corners 0, corner and corner + 1 of the face
+            size_t corner = 1;
+
+            // Like a polygon, a face has normals or tex coords only when every corner has them
+            bool has_normals = false;
+            bool has_tex_coords = false;
+
+            // Skips faces with less than 3 corners, they have no triangles
+            void seek_face();
+        };
+
+        explicit TriangleRange(MeshLayout const& layout) : TriangleRange(layout, 0, layout.faces().size()) {}
+
+        // Triangles of the faces [first_face, last_face), ranges of disjoint faces can be read from several threads
+        TriangleRange(MeshLayout const& layout, size_t first_face, size_t last_face) :
+            layout(&layout),
+            first_face(first_face),
+            last_face(last_face)
+        {
+            // Nothing
+        }
+
+        [[nodiscard]] const_iterator begin() const { return const_iterator(this->layout, this->first_face, this->last_face); }
+
+        [[nodiscard]] const_iterator end() const { return const_iterator(this->layout, this->last_face, this->last_face); }
+
+        // Every face of n >= 3 corners gives n - 2 triangles
+        [[nodiscard]] size_t size() const;
+
+    private:
+        MeshLayout const* layout;
+        size_t first_face;
+        size_t last_face;
+    };
+
+    // Number of elements every channel must have for the pushed faces to be valid,
+    // i.e. the largest index + 1 ignoring absent indices
+    struct IndexBounds {
+        size_t vertices = 0;
+        size_t normals = 0;
+        size_t tex_coords = 0;
+        size_t colors = 0;
     };
 
     class MeshLayoutBuilder {
@@ -195,30 +538,42 @@ namespace mesh {
         std::vector<glm::vec3> normals;
         std::vector<glm::vec2> tex_coords;
         std::vector<glm::vec4> colors;
-        std::vector<FaceLayout> faces;
+        FaceTable faces;
         std::vector<Triplet> triplets;
+        IndexBounds bounds;
+
+        void track_indices(size_t first_index);
 
         void validate_indices();
 
     public:
+        // Moves the collected data into the layout, the builder is left empty
         std::shared_ptr<MeshLayout> build();
 
         void push_vertex(glm::vec3 vertex);
 
         void push_vertices(std::vector<glm::vec3> const& items);
 
+        void push_vertices(std::vector<glm::vec3>&& items);
+
         void push_normal(glm::vec3 normal);
 
         void push_normals(std::vector<glm::vec3> const& items);
 
+        void push_normals(std::vector<glm::vec3>&& items);
+
         void push_tex_coord(glm::vec2 tex_coord);
 
         void push_tex_coords(std::vector<glm::vec2> const& items);
 
+        void push_tex_coords(std::vector<glm::vec2>&& items);
+
         void push_color(glm::vec4 color);
 
         void push_colors(std::vector<glm::vec4> const& items);
 
+        void push_colors(std::vector<glm::vec4>&& items);
+
         void push_triplet(Triplet const& triplet);
 
         void push_triplets(std::vector<Triplet> const& items);
@@ -237,24 +592,112 @@ namespace mesh {
 
         void push_triangles(std::vector<Triangle> const& items);
 
-        void push_face_layout(FaceLayout const& face);
+        void push_face(FaceView const& face);
 
-        void push_face_layouts(std::vector<FaceLayout> const& items);
+        void push_faces(FaceTable const& faces);
+
+        void push_faces(FaceTable&& faces);
     };
 
     class TriangulationStrategy {
     public:
-        virtual std::vector<Triangle> triangulate(Polygon &polygon) = 0;
+        virtual ~TriangulationStrategy() = default;
+
+        virtual std::vector<Triangle> triangulate(Polygon const& polygon) = 0;
+
+        // Appends the triangles of the polygon, a caller reusing the vector across polygons doesn't allocate per polygon
+        virtual void triangulate_into(Polygon const& polygon, std::vector<Triangle>& triangles);
+
+        // Appends three corner positions per triangle of the face, positions index the face table columns
+        virtual void triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) = 0;
+
+        // Same corners written to a caller provided buffer with room for the n - 2 triangles of a face of n corners,
+        // returns the triangles written. Parallel triangulation gives every thread its own part of one buffer
+        virtual size_t triangulate_face_into(MeshLayout const& layout, size_t face, index_t* corners);
+
+        // Independent instance for another thread, nullptr when the strategy can only triangulate on one thread
+        [[nodiscard]] virtual std::unique_ptr<TriangulationStrategy> clone() const { return nullptr; }
+
+        // False when the triangles depend on the faces alone, layouts sharing the faces then share the triangulation
+        [[nodiscard]] virtual bool uses_positions() const { return true; }
+
+        // True when the triangles are the ones TriangleRange makes, readers then make them on the fly
+        // instead of building the cached triangulation
+        [[nodiscard]] virtual bool is_fan() const { return false; }
     };
 
+    // Reference fan, quadratic in the polygon size, FanTriangulationStrategy yields the same triangles
     class DummyTriangulationStrategy : public TriangulationStrategy {
     public:
-        std::vector<Triangle> triangulate(Polygon &polygon) override;
+        std::vector<Triangle> triangulate(Polygon const& polygon) override;
+
+        void triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) override;
+
+        [[nodiscard]] std::unique_ptr<TriangulationStrategy> clone() const override;
+
+        [[nodiscard]] bool uses_positions() const override { return false; }
+
+        [[nodiscard]] bool is_fan() const override { return true; }
+    };
+
+    // Fan around the first corner in a single pass, triangles and quads go through unrolled paths
+    class FanTriangulationStrategy : public TriangulationStrategy {
+    public:
+        std::vector<Triangle> triangulate(Polygon const& polygon) override;
+
+        void triangulate_into(Polygon const& polygon, std::vector<Triangle>& triangles) override;
+
+        void triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) override;
+
+        size_t triangulate_face_into(MeshLayout const& layout, size_t face, index_t* corners) override;
+
+        [[nodiscard]] std::unique_ptr<TriangulationStrategy> clone() const override;
+
+        [[nodiscard]] bool uses_positions() const override { return false; }
+
+        [[nodiscard]] bool is_fan() const override { return true; }
+    };
+
+    struct EarNode;
+
+    // Ear clipping in the plane the face is most parallel to, correct for concave faces unlike a fan.
+    // Large faces look up points inside candidate ears in a uniform grid, which keeps faces
+    // with 100k corners fast. Keeps scratch buffers between faces, so an instance isn't thread safe,
+    // parallel triangulation works on clones
+    class EarClippingTriangulationStrategy : public TriangulationStrategy {
+    public:
+        EarClippingTriangulationStrategy();
+
+        ~EarClippingTriangulationStrategy() override;
+
+        std::vector<Triangle> triangulate(Polygon const& polygon) override;
+
+        void triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) override;
+
+        size_t triangulate_face_into(MeshLayout const& layout, size_t face, index_t* corners) override;
+
+        [[nodiscard]] std::unique_ptr<TriangulationStrategy> clone() const override;
+
+    private:
+        std::vector<glm::vec3> points;
+        std::vector<glm::dvec2> projected;
+        std::vector<EarNode> nodes;
+        std::vector<EarNode*> cells;
+        std::vector<EarNode*> candidates;
+
+        // Corner triples of the last triangulated points
+        std::vector<size_t> corners;
+
+        void triangulate_points(std::vector<glm::vec3> const& points);
+
+        // Corners of the face in points, their triangulation in corners
+        void triangulate_face_points(MeshLayout const& layout, size_t face);
     };
 
     class MeshLayoutReader {
         std::shared_ptr<MeshLayout> layout;
         std::shared_ptr<TriangulationStrategy> triangulation_strategy;
+        size_t threads;
 
         std::vector<Triangle> triangles_data;
         std::vector<Polygon> polygons_data;
@@ -262,18 +705,73 @@ namespace mesh {
         std::vector<TripletFace> triplet_faces_data;
 
     public:
+        // Threads triangulate the layout and build the triangles vector
         MeshLayoutReader(
             std::shared_ptr<MeshLayout> layout,
-            std::shared_ptr<TriangulationStrategy> triangulation_strategy
+            std::shared_ptr<TriangulationStrategy> triangulation_strategy,
+            size_t threads = 1
         ) :
             layout(std::move(layout)),
-            triangulation_strategy(std::move(triangulation_strategy))
+            triangulation_strategy(std::move(triangulation_strategy)),
+            threads(threads)
         {
             // Nothing
         }
 
         std::vector<Triangle> const& triangles();
 
+        [[nodiscard]] TriangleRange triangle_range() const {
+            return TriangleRange(*this->layout);
+        }
+
+        // Triangles are read in parts: faces when the strategy is a fan, which is made on the fly by TriangleRange
+        // and allocates nothing, triangles of the cached triangulation for the other strategies.
+        // Consecutive parts give consecutive triangles, so threads can split the parts between them
+        size_t parts_count() {
+            if (this->triangulation_strategy->is_fan()) {
+                return this->layout->faces().size();
+            }
+
+            return this->triangulation()->size();
+        }
+
+        // Triangles count of the parts [begin, end)
+        size_t triangles_count(size_t begin, size_t end) {
+            if (this->triangulation_strategy->is_fan()) {
+                return TriangleRange(*this->layout, begin, end).size();
+            }
+
+            return end - begin;
+        }
+
+        size_t triangles_count() {
+            return this->triangles_count(0, this->parts_count());
+        }
+
+        // Passes the triangles of the parts [begin, end) to the callback one by one,
+        // can be called for disjoint parts from several threads
+        template<typename Callback>
+        void for_each_triangle(size_t begin, size_t end, Callback&& callback) {
+            if (this->triangulation_strategy->is_fan()) {
+                for (auto const& triangle : TriangleRange(*this->layout, begin, end)) {
+                    callback(triangle);
+                }
+
+                return;
+            }
+
+            const auto triangulation = this->triangulation();
+
+            for (size_t i = begin; i < end; i++) {
+                callback(triangulation->get_triangle(*this->layout, i));
+            }
+        }
+
+        template<typename Callback>
+        void for_each_triangle(Callback&& callback) {
+            this->for_each_triangle(0, this->parts_count(), std::forward<Callback>(callback));
+        }
+
         std::vector<Polygon> const& polygons();
 
         std::vector<glm::vec3> const& vertices();
@@ -285,5 +783,12 @@ namespace mesh {
         std::vector<Triplet> const& triplets();
 
         std::vector<TripletFace> const& triplet_faces();
+
+    private:
+        [[nodiscard]] Polygon get_polygon(FaceView const& face) const;
+
+        [[nodiscard]] std::shared_ptr<const TriangleIndexBuffer> triangulation() const {
+            return this->layout->triangulation(*this->triangulation_strategy, this->threads);
+        }
     };
 }
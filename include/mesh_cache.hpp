@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <exception>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace mesh_cache {
+
+    // Bump on every change of the binary layout, caches with another version are rebuilt
+    constexpr uint32_t version = 3;
+
+    struct CacheException : public std::exception {
+        [[nodiscard]] const char* what() const noexcept override {
+            return "mesh cache is corrupted";
+        }
+    };
+
+    // Identifies the source file the cache was built from
+    struct SourceKey {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+
+        bool operator==(SourceKey const& other) const {
+            return this->size == other.size && this->mtime == other.mtime;
+        }
+    };
+
+    SourceKey get_source_key(std::string const& source_path);
+
+    // Cache lives next to the source: <source_path>.meshcache
+    std::string get_cache_path(std::string const& source_path);
+
+    // Raw mesh layout arrays in native byte order and index width behind a versioned header
+    void write_to_file(std::string const& cache_path, SourceKey const& key, mesh::MeshLayout const& layout);
+
+    // Arrays are copied out of the mapped file into the layout, a load reads the whole cache once.
+    // Returns nullptr when the cache doesn't exist, has another version or index width or was built from another source,
+    // throws CacheException when the file is truncated or holds invalid indices
+    std::shared_ptr<mesh::MeshLayout> read_from_file(std::string const& cache_path, SourceKey const& key);
+
+    // Cache of the source, nullptr on a miss, a corrupted or unreadable cache is a miss as well
+    std::shared_ptr<mesh::MeshLayout> load(std::string const& source_path, SourceKey const& key);
+
+    // Written to a temporary file first and renamed, so readers never see a partial cache
+    void save(std::string const& source_path, SourceKey const& key, mesh::MeshLayout const& layout);
+
+}
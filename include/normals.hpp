@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace normals {
+
+    // Triangles handled by one call of the kernel, one 512-bit register or two 256-bit ones per coordinate
+    constexpr size_t block_size = 16;
+
+    enum class Isa {
+        Scalar,
+        Avx2,
+        Avx512,
+    };
+
+    using Lanes = std::array<float, block_size>;
+
+    // Structure of arrays, axis a of corner k of every triangle is in corners[3 * k + a]
+    struct TriangleBlock {
+        std::array<Lanes, 9> corners;
+    };
+
+    // Axis a of every normal is in axes[a]
+    struct NormalBlock {
+        std::array<Lanes, 3> axes;
+    };
+
+    bool is_supported(Isa isa);
+
+    // Selected once at runtime from the cpu features
+    Isa best_isa();
+
+    // Normalized cross product of the edges from the first corner, all lanes are computed.
+    // Every isa does the operations of utils::calculate_normal in the same order, without fused multiply-add
+    // or approximate square roots, so the results agree with it
+    void calculate_normals(TriangleBlock const& triangles, NormalBlock& normals, Isa isa);
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <utility>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <exception>
@@ -28,7 +29,7 @@ namespace obj_file {
         size_t vt;
         size_t vn;
 
-        Triplet(int v, int vt, int vn) {
+        Triplet(size_t v, size_t vt, size_t vn) {
             this->v = v;
             this->vt = vt;
             this->vn = vn;
@@ -41,35 +42,78 @@ namespace obj_file {
         }
     };
 
-    struct Face {
-        const std::vector<Triplet> triplets;
-
+    class Face {
+    public:
         explicit Face(std::vector<Triplet> triplets)
-            : triplets(std::move(triplets)) {}
-    };
+            : triplets_data(std::move(triplets)) {}
 
-    struct ObjStruct {
-        const std::vector<glm::vec3> v;
-        const std::vector<glm::vec2> vt;
-        const std::vector<glm::vec3> vn;
-        const std::vector<Face> f;
+        [[nodiscard]] std::vector<Triplet> const& triplets() const { return this->triplets_data; }
 
+    private:
+        std::vector<Triplet> triplets_data;
+    };
+
+    class ObjStruct {
+    public:
         ObjStruct(
             std::vector<glm::vec3> v,
             std::vector<glm::vec2> vt,
             std::vector<glm::vec3> vn,
             std::vector<Face> f
         ) :
-            v(std::move(v)),
-            vt(std::move(vt)),
-            vn(std::move(vn)),
-            f(std::move(f))
+            v_data(std::move(v)),
+            vt_data(std::move(vt)),
+            vn_data(std::move(vn)),
+            f_data(std::move(f))
         {
             // Nothing
         }
+
+        [[nodiscard]] std::vector<glm::vec3> const& v() const { return this->v_data; }
+
+        [[nodiscard]] std::vector<glm::vec2> const& vt() const { return this->vt_data; }
+
+        [[nodiscard]] std::vector<glm::vec3> const& vn() const { return this->vn_data; }
+
+        [[nodiscard]] std::vector<Face> const& f() const { return this->f_data; }
+
+    private:
+        std::vector<glm::vec3> v_data;
+        std::vector<glm::vec2> vt_data;
+        std::vector<glm::vec3> vn_data;
+        std::vector<Face> f_data;
+    };
+
+    // Receives elements in file order while parsing, without building the whole ObjStruct
+    class ObjHandler {
+    public:
+        virtual ~ObjHandler() = default;
+
+        virtual void on_vertex(glm::vec3 const& /*v*/) {}
+
+        virtual void on_tex_coord(glm::vec2 const& /*vt*/) {}
+
+        virtual void on_normal(glm::vec3 const& /*vn*/) {}
+
+        virtual void on_face(std::vector<Triplet> const& /*triplets*/) {}
     };
 
     ObjStruct load_from_string_lines(std::vector<std::string> const& lines);
 
+    // Parse obj directly from a text buffer (e.g. a memory mapped file) without splitting it into lines,
+    // with threads > 1 the buffer is split at line boundaries and the chunks are parsed concurrently
+    ObjStruct load_from_string(std::string_view data, size_t threads = 1);
+
+    ObjStruct load_from_file(std::string const& filepath, size_t threads = 1);
+
+    // Sequential single pass parse, relative indices are resolved before on_face is called
+    void stream_from_string(std::string_view data, ObjHandler& handler);
+
     std::shared_ptr<mesh::MeshLayout> create_mesh_layout_from_obj(ObjStruct const& obj);
+
+    // Same as create_mesh_layout_from_obj(load_from_string(data)), but the parsed data
+    // is moved into the layout instead of being copied through ObjStruct
+    std::shared_ptr<mesh::MeshLayout> load_mesh_layout_from_string(std::string_view data, size_t threads = 1);
+
+    std::shared_ptr<mesh::MeshLayout> load_mesh_layout_from_file(std::string const& filepath, size_t threads = 1);
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace scan {
+
+    constexpr size_t block_size = 64;
+
+    enum class Isa {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // Bit i of a mask is set when byte i of the block belongs to the class
+    struct BlockMasks {
+        uint64_t newlines;
+        uint64_t spaces;
+        uint64_t slashes;
+    };
+
+    bool is_supported(Isa isa);
+
+    // Selected once at runtime from the cpu features
+    Isa best_isa();
+
+    // Block must have block_size readable bytes, spaces are ' ' and '\t'
+    BlockMasks classify_block(const char* block, Isa isa);
+
+    // Splits text into lines and reports offsets of spaces and slashes inside every line.
+    // Text is classified a block at a time, so the per line work is only bit iteration.
+    class LineScanner {
+    public:
+        explicit LineScanner(std::string_view text) : LineScanner(text, best_isa()) {}
+
+        LineScanner(std::string_view text, Isa isa) : text(text), isa(isa) {}
+
+        // Line doesn't include the newline, returns false when there are no more lines
+        bool next_line(std::string_view& line, std::vector<uint32_t>& delimiters);
+
+    private:
+        std::string_view text;
+        Isa isa;
+        size_t position = 0;
+        size_t block_start = 0;
+        bool block_loaded = false;
+        BlockMasks masks {0, 0, 0};
+
+        void load_block(size_t start);
+    };
+
+}
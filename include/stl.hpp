@@ -1,24 +1,133 @@
 #pragma once
 
+#include <fstream>
+
 #include "format.hpp"
+#include "utils.hpp"
 
 namespace stl_file {
 
-    class StlMeshWriter : public mesh_format::MeshWriter {
+    struct ParseException : public std::exception {
+        [[nodiscard]] const char* what() const noexcept override {
+            return "parse stl file error";
+        }
+    };
+
+    // Binary stl stores the triangles count as uint32
+    struct TooManyTrianglesException : public std::exception {
+        [[nodiscard]] const char* what() const noexcept override {
+            return "too many triangles for stl file";
+        }
+    };
+
+    class StlMeshWriter : public mesh_format::BatchMeshWriter<StlMeshWriter> {
     public:
-        StlMeshWriter() : MeshWriter(
+        StlMeshWriter() : BatchMeshWriter(
             mesh_format::FileType::Binary,
             mesh_format::ByteOrder::LittleEndian
         ) {}
 
+        explicit StlMeshWriter(std::shared_ptr<mesh::TriangulationStrategy> triangulation_strategy, size_t threads = 1) :
+            BatchMeshWriter(
+                mesh_format::FileType::Binary,
+                mesh_format::ByteOrder::LittleEndian,
+                std::move(triangulation_strategy),
+                threads
+            )
+        {}
+
     private:
+        friend class mesh_format::BatchMeshWriter<StlMeshWriter>;
+
+        void write_header() override;
+
+        void write_layout() override;
+
+        // The normals are computed a block of triangles at a time
+        void write_triangle_block(const mesh::Triangle* triangles, size_t count);
+
+        // Every triangle takes the same 50 bytes, so with several threads and a sink that can allocate
+        // the output each thread encodes its range of triangles straight into place.
+        // Returns false when the triangles are left to the sequential writer
+        bool write_triangles_parallel(size_t triangles_count);
+    };
+
+    // Ascii stl, floats are in the shortest form that reads back to the same value
+    class StlTextMeshWriter : public mesh_format::BatchMeshWriter<StlTextMeshWriter> {
+    public:
+        StlTextMeshWriter() : StlTextMeshWriter(std::make_shared<mesh::FanTriangulationStrategy>()) {}
+
+        explicit StlTextMeshWriter(std::shared_ptr<mesh::TriangulationStrategy> triangulation_strategy, size_t threads = 1) :
+            BatchMeshWriter(
+                mesh_format::FileType::Text,
+                mesh_format::ByteOrder::Native,
+                std::move(triangulation_strategy),
+                threads
+            )
+        {}
+
+    private:
+        friend class mesh_format::BatchMeshWriter<StlTextMeshWriter>;
+
         void write_header() override;
 
         void write_layout() override;
 
-        void write_triangles(std::vector<mesh::Triangle> const& triangles) override;
+        // The normals are computed a block of triangles at a time
+        void write_triangle_block(const mesh::Triangle* triangles, size_t count);
+
+        // Triangles have different lengths, so batches of them are encoded on threads into a buffer
+        // per thread and the buffers are passed to the sink in order.
+        // Returns false when the triangles are left to the sequential writer
+        bool write_triangles_parallel(size_t triangles_count);
+    };
+
+    // Writes binary stl to the file incrementally through a fixed size buffer,
+    // the triangles count in the header is patched on finish
+    class StlStreamWriter {
+    public:
+        explicit StlStreamWriter(std::string const& filepath);
+
+        void write_triangle(mesh::Triangle const& triangle);
+
+        void finish();
+
+        [[nodiscard]] uint32_t get_triangles_count() const;
+
+    private:
+        std::ofstream stream;
+        mesh_format::BytesWriter writer;
+        uint32_t triangles_count = 0;
+
+        void flush();
+    };
+
+
+    // Triangles of an stl file. Binary files are read in place from the mapping, nothing is copied,
+    // ascii ones are parsed once into records of the binary layout.
+    // Throws std::ifstream::failure when the file can't be read and ParseException when it's not stl
+    class StlTriangleView {
+    public:
+        explicit StlTriangleView(std::string const& filepath);
+
+        [[nodiscard]] size_t size() const { return this->count; }
+
+        // With the normal stored in the file
+        [[nodiscard]] mesh::Triangle get_triangle(size_t index) const;
+
+        // Indexed layout for consumers that need connectivity, corners at the same position, or in the same
+        // cell of a weld_grid sized grid, share a vertex, see calc::weld_vertices.
+        // Stored normals are left out, writers compute them from the vertices
+        [[nodiscard]] std::shared_ptr<mesh::MeshLayout> build_layout(size_t threads = 1, float weld_grid = 0) const;
+
+    private:
+        utils::MappedFile file;
+        std::vector<char> parsed_records;
+        const char* records = nullptr;
+        size_t count = 0;
+        bool swap_endian = false;
 
-        void write_triangle(mesh::Triangle const& triangle) override;
+        void parse_text(std::string_view text);
     };
 
 }
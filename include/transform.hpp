@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+namespace transform {
+
+    enum class Isa {
+        Scalar,
+        Avx2,
+    };
+
+    // Upper three rows of an affine 4x4 matrix, row r maps a point p to dot(rows[r], (p, 1))
+    using AffineMatrix = std::array<std::array<float, 4>, 3>;
+
+    AffineMatrix get_point_matrix(glm::mat4 const& matrix);
+
+    // Inverse transpose of the upper left 3x3 without the translation, so normals stay perpendicular
+    // to the surface under non-uniform scale
+    AffineMatrix get_normal_matrix(glm::mat4 const& matrix);
+
+    bool is_supported(Isa isa);
+
+    // Selected once at runtime from the cpu features
+    Isa best_isa();
+
+    // Rounded like the kernels, (m0 * x + m1 * y) + (m2 * z + m3) per row
+    glm::vec3 transform_point(AffineMatrix const& matrix, glm::vec3 point);
+
+    // Output may be the input itself for an in-place transform, otherwise they don't overlap
+    void transform_points(const glm::vec3* input, glm::vec3* output, size_t count, AffineMatrix const& matrix, Isa isa);
+
+    // Transformed by a normal matrix and normalized, zero normals stay zero. Same aliasing as transform_points
+    void transform_normals(const glm::vec3* input, glm::vec3* output, size_t count, AffineMatrix const& matrix, Isa isa);
+
+}
@@ -4,6 +4,9 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <exception>
+#include <string_view>
+#include <thread>
 #include <glm/glm.hpp>
 
 #include "mesh.hpp"
@@ -14,6 +17,26 @@ namespace utils {
 
     std::vector<std::string> load_text_file_lines(std::string const& filepath);
 
+    // Read-only memory mapping of a whole file, unmapped on destruction
+    class MappedFile {
+    public:
+        explicit MappedFile(std::string const& filepath);
+
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        [[nodiscard]] std::string_view view() const;
+
+        [[nodiscard]] size_t size() const;
+
+    private:
+        void* data = nullptr;
+        size_t length = 0;
+    };
+
     std::vector<std::string> split(std::string const& src, char delimiter);
 
     // Original version: https://mklimenko.github.io/english/2018/08/22/robust-endian-swap/
@@ -29,6 +52,41 @@ namespace utils {
         val = dst.val;
     }
 
+    // Run task(index) for every index in [0, count), each on its own thread.
+    // The first exception thrown by a task is rethrown once all threads are joined.
+    template<typename Task>
+    void run_parallel(size_t count, Task const& task) {
+        if (count == 1) {
+            task(0);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(count);
+        threads.reserve(count);
+
+        for (size_t i = 0; i < count; i++) {
+            threads.emplace_back([&task, &errors, i] {
+                try {
+                    task(i);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (auto const& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
     bool is_big_endian();
 
     bool is_little_endian();
@@ -2,6 +2,7 @@
 #include "utils.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace mesh_format {
     std::vector<std::byte> const& BytesWriter::get_bytes() {
@@ -35,46 +36,80 @@ namespace mesh_format {
         return mismatch_big_endian || mismatch_little_endian;
     }
 
-    void BytesWriter::write_int32_t(int32_t value) {
-        assert(this->file_type == FileType::Binary);
+    void BytesWriter::reserve(size_t size) {
+        this->bytes.reserve(size);
+    }
+
+    std::byte* BytesWriter::append(size_t size) {
+        const auto offset = this->bytes.size();
+        this->bytes.resize(offset + size);
+        return this->bytes.data() + offset;
+    }
+
+    // Written with shifts so the compiler turns the loop into vector byte shuffles
+    static void copy_swapped_32(std::byte* output, const void* input, size_t count) {
+        const auto words = static_cast<const std::byte*>(input);
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t word;
+            std::memcpy(&word, words + i * sizeof(uint32_t), sizeof(uint32_t));
+
+            word = (word >> 24) | ((word >> 8) & 0x0000ff00u) | ((word << 8) & 0x00ff0000u) | (word << 24);
+            std::memcpy(output + i * sizeof(uint32_t), &word, sizeof(uint32_t));
+        }
+    }
 
-        if (this->is_endian_mismatch()) {
-            utils::swap_endian(value);
+    void BytesWriter::store_floats(std::byte* output, const float* values, size_t count) const {
+        static_assert(sizeof(float) == sizeof(uint32_t));
+
+        if (this->endian_mismatch) {
+            copy_swapped_32(output, values, count);
+        }
+        else {
+            std::memcpy(output, values, count * sizeof(float));
         }
+    }
 
-        union {
-            int32_t val;
-            std::array<std::byte, sizeof(int32_t)> raw;
-        } union_value {};
+    void BytesWriter::write_int32_t(int32_t value) {
+        assert(this->file_type == FileType::Binary);
 
-        union_value.val = value;
+        const auto output = this->append(sizeof(int32_t));
 
-        std::copy(
-            union_value.raw.begin(),
-            union_value.raw.end(),
-            std::back_inserter(this->bytes)
-        );
+        if (this->endian_mismatch) {
+            copy_swapped_32(output, &value, 1);
+        }
+        else {
+            std::memcpy(output, &value, sizeof(int32_t));
+        }
     }
 
-    void BytesWriter::write_float(float value) {
+    void BytesWriter::write_uint32_t(uint32_t value) {
         assert(this->file_type == FileType::Binary);
 
-        if (this->is_endian_mismatch()) {
-            utils::swap_endian(value);
+        const auto output = this->append(sizeof(uint32_t));
+
+        if (this->endian_mismatch) {
+            copy_swapped_32(output, &value, 1);
+        }
+        else {
+            std::memcpy(output, &value, sizeof(uint32_t));
         }
+    }
 
-        union {
-            float val;
-            std::array<std::byte, sizeof(int32_t)> raw;
-        } union_value {};
+    void BytesWriter::write_float(float value) {
+        this->write_floats(&value, 1);
+    }
 
-        union_value.val = value;
+    void BytesWriter::write_floats(const float* values, size_t count) {
+        assert(this->file_type == FileType::Binary);
+        this->store_floats(this->append(count * sizeof(float)), values, count);
+    }
 
-        std::copy(
-            union_value.raw.begin(),
-            union_value.raw.end(),
-            std::back_inserter(this->bytes)
-        );
+    void BytesWriter::write_record(const float* values, size_t count, size_t padding) {
+        assert(this->file_type == FileType::Binary);
+
+        // Resized bytes are zeroed, so the padding is already there
+        this->store_floats(this->append(count * sizeof(float) + padding), values, count);
     }
 
     void BytesWriter::write_byte(std::byte byte) {
@@ -94,13 +129,17 @@ namespace mesh_format {
         this->bytes.push_back(std::byte(ch));
     }
 
+    void BytesWriter::write_chars(const char* chars, size_t size) {
+        // memcpy doesn't accept null pointers even for empty ranges
+        if (size == 0) {
+            return;
+        }
+
+        std::memcpy(this->append(size), chars, size);
+    }
+
     void BytesWriter::write_string(std::string const& str) {
-        std::transform(
-            str.begin(),
-            str.end(),
-            std::back_inserter(this->bytes),
-            [] (const char c) { return std::byte(c); }
-        );
+        this->write_chars(str.data(), str.size());
     }
 
 }
@@ -1,16 +1,15 @@
 #include "calc.hpp"
 
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <utility>
 #include "utils.hpp"
+#include "transform.hpp"
 
 namespace calc {
 
-    std::shared_ptr<mesh::MeshLayout> apply_transforms_to_layout(
-        std::shared_ptr<mesh::MeshLayout> const& layout,
-        glm::vec3 pos,
-        glm::vec3 rotation,
-        glm::vec3 scale
-    ) {
+    glm::mat4 create_transform_matrix(glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale) {
         const auto translate_matrix = glm::translate(glm::mat4(1), pos);
 
         const auto rotate_x_matrix = glm::rotate(
@@ -34,75 +33,428 @@ namespace calc {
         const auto scale_matrix = glm::scale(glm::mat4(1), scale);
 
         const auto rotate_matrix = rotate_x_matrix * rotate_y_matrix * rotate_z_matrix;
-        const auto model_matrix = translate_matrix * rotate_matrix * scale_matrix;
+        return translate_matrix * rotate_matrix * scale_matrix;
+    }
+
+    // Fewer vertices per thread aren't worth starting the thread for
+    static constexpr size_t min_vertices_per_thread = 1 << 16;
+
+    static bool is_translation(glm::mat4 const& matrix) {
+        for (int column = 0; column < 3; column++) {
+            for (int row = 0; row < 3; row++) {
+                if (matrix[column][row] != (column == row ? 1.0f : 0.0f)) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<mesh::MeshLayout> apply_transforms_to_layout(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        glm::vec3 pos,
+        glm::vec3 rotation,
+        glm::vec3 scale,
+        size_t threads
+    ) {
+        // Nothing to transform, the layout keeps its cached triangulation
+        if (pos == glm::vec3(0) && rotation == glm::vec3(0) && scale == glm::vec3(1)) {
+            return layout;
+        }
+
+        const auto model_matrix = create_transform_matrix(pos, rotation, scale);
+        const auto point_matrix = transform::get_point_matrix(model_matrix);
+        const auto normal_matrix = transform::get_normal_matrix(model_matrix);
+        const auto isa = transform::best_isa();
+
+        auto const& vertices = layout->vertices();
+        auto const& normals = layout->normals();
+
+        // A translation doesn't turn the normals
+        const bool keep_normals = is_translation(model_matrix);
+
+        std::vector<glm::vec3> new_vertices(vertices.size());
+        std::vector<glm::vec3> new_normals(keep_normals ? 0 : normals.size());
+
+        const auto count = std::max(vertices.size(), new_normals.size());
+        const auto chunks_count = std::max<size_t>(1, std::min(threads, count / min_vertices_per_thread));
+
+        // Every chunk transforms a range of the vertices and the same range of the normals
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            const auto begin = count * chunk / chunks_count;
+            const auto end = count * (chunk + 1) / chunks_count;
+
+            if (begin < vertices.size()) {
+                const auto vertices_end = std::min(end, vertices.size());
+                transform::transform_points(&vertices[begin], &new_vertices[begin], vertices_end - begin, point_matrix, isa);
+            }
+
+            if (begin < new_normals.size()) {
+                const auto normals_end = std::min(end, new_normals.size());
+                transform::transform_normals(&normals[begin], &new_normals[begin], normals_end - begin, normal_matrix, isa);
+            }
+        });
+
+        // Faces, tex coords and colors are the same, they are shared with the source layout
+        // and so is the triangulation of the strategies that don't look at the positions
+        return std::make_shared<mesh::MeshLayout>(
+            std::make_shared<const std::vector<glm::vec3>>(std::move(new_vertices)),
+            keep_normals ? layout->shared_normals() : std::make_shared<const std::vector<glm::vec3>>(std::move(new_normals)),
+            layout->shared_tex_coords(),
+            layout->shared_colors(),
+            layout->shared_faces(),
+            layout->shared_triangulation_cache()
+        );
+    }
+
+    // Vertices with equal keys are welded, with grid_size > 0 the key is the grid cell of the vertex
+    using WeldKey = std::array<int64_t, 3>;
+
+    static WeldKey get_weld_key(glm::vec3 const& vertex, float grid_size) {
+        WeldKey key {};
+
+        for (size_t i = 0; i < 3; i++) {
+            if (grid_size > 0) {
+                const double cell = std::floor(double(vertex[i]) / grid_size);
+
+                if (std::abs(cell) < 1e18) {
+                    key[i] = int64_t(cell);
+                    continue;
+                }
+            }
+
+            // Exact positions compare by bits, adding zero turns -0 into 0 so both weld.
+            // Bits are above any cell, so infinities and nans only weld with themselves
+            const float value = vertex[i] + 0.0f;
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            key[i] = int64_t(bits) | (int64_t(1) << 62);
+        }
+
+        return key;
+    }
+
+    static uint64_t hash_weld_key(WeldKey const& key) {
+        uint64_t hash = 0;
+
+        for (const auto value : key) {
+            hash = (hash ^ uint64_t(value)) * 0x9e3779b97f4a7c15ull;
+            hash ^= hash >> 32;
+        }
+
+        return hash;
+    }
+
+    // The vertices are partitioned by the hash of their keys, so equal keys end up in the same partition
+    // and each thread welds its own partition with an open addressing table. Every vertex gets the first
+    // vertex with its key as the representative, representatives are numbered in order of the vertices.
+    // Returns the welded vertices, new_indices maps every vertex to its welded one
+    static std::vector<glm::vec3> weld_positions(
+        std::vector<glm::vec3> const& vertices,
+        float grid_size,
+        size_t threads,
+        std::vector<mesh::index_t>& new_indices
+    ) {
+        const size_t count = vertices.size();
+        const size_t chunks_count = std::max(size_t(1), std::min(threads, count / min_vertices_per_thread));
+
+        const auto chunk_begin = [&](size_t chunk) { return count * chunk / chunks_count; };
+        const auto key_of = [&](mesh::index_t vertex) { return get_weld_key(vertices[vertex], grid_size); };
+
+        // Vertices of every chunk in every partition
+        std::vector<uint64_t> hashes(count);
+        std::vector<std::vector<size_t>> offsets(chunks_count, std::vector<size_t>(chunks_count));
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+                hashes[i] = hash_weld_key(key_of(mesh::index_t(i)));
+                offsets[chunk][hashes[i] % chunks_count]++;
+            }
+        });
+
+        // Partitions are contiguous and inside of them the chunks go in order,
+        // so every partition lists its vertices in increasing order
+        std::vector<size_t> partitions_begin(chunks_count + 1);
+        size_t offset = 0;
+
+        for (size_t partition = 0; partition < chunks_count; partition++) {
+            partitions_begin[partition] = offset;
+
+            for (size_t chunk = 0; chunk < chunks_count; chunk++) {
+                offset += std::exchange(offsets[chunk][partition], offset);
+            }
+        }
+
+        partitions_begin[chunks_count] = offset;
+
+        std::vector<mesh::index_t> order(count);
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+                order[offsets[chunk][hashes[i] % chunks_count]++] = mesh::index_t(i);
+            }
+        });
+
+        std::vector<mesh::index_t> representatives(count);
+
+        utils::run_parallel(chunks_count, [&](size_t partition) {
+            const auto begin = partitions_begin[partition];
+            const auto end = partitions_begin[partition + 1];
+
+            // At most half full, slots hold the representatives
+            size_t capacity = 16;
+
+            while (capacity < 2 * (end - begin)) {
+                capacity *= 2;
+            }
+
+            std::vector<mesh::index_t> table(capacity, mesh::absent_index);
+
+            for (size_t i = begin; i < end; i++) {
+                const auto vertex = order[i];
+                const auto key = key_of(vertex);
+
+                // Low bits chose the partition
+                auto slot = (hashes[vertex] >> 16) & (capacity - 1);
+
+                while (table[slot] != mesh::absent_index && key_of(table[slot]) != key) {
+                    slot = (slot + 1) & (capacity - 1);
+                }
 
-        auto builder = std::make_unique<mesh::MeshLayoutBuilder>();
+                if (table[slot] == mesh::absent_index) {
+                    table[slot] = vertex;
+                }
 
-        builder->push_normals(layout->normals);
-        builder->push_tex_coords(layout->tex_coords);
-        builder->push_colors(layout->colors);
-        builder->push_face_layouts(layout->faces);
+                representatives[vertex] = table[slot];
+            }
+        });
+
+        // Representatives are numbered after the ones of the previous chunks
+        std::vector<size_t> chunks_offsets(chunks_count + 1);
 
-        for (auto const& vertex : layout->vertices) {
-            auto new_vertex = model_matrix * glm::vec4(vertex, 1.0f);
-            builder->push_vertex(glm::vec3(new_vertex));
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+                chunks_offsets[chunk + 1] += representatives[i] == i ? 1 : 0;
+            }
+        });
+
+        for (size_t chunk = 0; chunk < chunks_count; chunk++) {
+            chunks_offsets[chunk + 1] += chunks_offsets[chunk];
         }
 
-        return builder->build();
+        std::vector<glm::vec3> welded_vertices(chunks_offsets[chunks_count]);
+        new_indices.resize(count);
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            auto index = chunks_offsets[chunk];
+
+            for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+                if (representatives[i] == i) {
+                    welded_vertices[index] = vertices[i];
+                    new_indices[i] = mesh::index_t(index++);
+                }
+            }
+        });
+
+        // Representatives come first but may be in other chunks, so they're only read once all are numbered
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+                if (representatives[i] != i) {
+                    new_indices[i] = new_indices[representatives[i]];
+                }
+            }
+        });
+
+        return welded_vertices;
+    }
+
+    // Output may be the indices themselves
+    static void reindex(
+        std::vector<mesh::index_t> const& indices,
+        std::vector<mesh::index_t> const& new_indices,
+        std::vector<mesh::index_t>& output,
+        size_t threads
+    ) {
+        const size_t chunks_count = std::max(size_t(1), std::min(threads, indices.size() / min_vertices_per_thread));
+        output.resize(indices.size());
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            const size_t end = indices.size() * (chunk + 1) / chunks_count;
+
+            for (size_t i = indices.size() * chunk / chunks_count; i < end; i++) {
+                output[i] = new_indices[indices[i]];
+            }
+        });
+    }
+
+    std::shared_ptr<mesh::MeshLayout> weld_vertices(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        float grid_size,
+        size_t threads
+    ) {
+        std::vector<mesh::index_t> new_indices;
+        auto welded_vertices = weld_positions(layout->vertices(), grid_size, threads, new_indices);
+
+        // Source faces stay as they are, the vertices column is written once straight into the new table
+        auto const& source_faces = layout->faces();
+        mesh::FaceTable faces;
+        faces.offsets = source_faces.offsets;
+        faces.normals_indices = source_faces.normals_indices;
+        faces.tex_coord_indices = source_faces.tex_coord_indices;
+        faces.color_indices = source_faces.color_indices;
+        reindex(source_faces.vertices_indices, new_indices, faces.vertices_indices, threads);
+
+        return std::make_shared<mesh::MeshLayout>(
+            std::make_shared<const std::vector<glm::vec3>>(std::move(welded_vertices)),
+            layout->shared_normals(),
+            layout->shared_tex_coords(),
+            layout->shared_colors(),
+            std::make_shared<const mesh::FaceTable>(std::move(faces))
+        );
+    }
+
+    void weld_vertices(std::vector<glm::vec3>& vertices, mesh::FaceTable& faces, float grid_size, size_t threads) {
+        std::vector<mesh::index_t> new_indices;
+        vertices = weld_positions(vertices, grid_size, threads, new_indices);
+        reindex(faces.vertices_indices, new_indices, faces.vertices_indices, threads);
     }
 
     static double triangle_area(mesh::Triangle const& triangle) {
-        const glm::vec3 a = triangle.vertices[1] - triangle.vertices[0];
-        const glm::vec3 b = triangle.vertices[2] - triangle.vertices[0];
+        const glm::vec3 a = triangle.vertices()[1] - triangle.vertices()[0];
+        const glm::vec3 b = triangle.vertices()[2] - triangle.vertices()[0];
         const glm::vec3 c = glm::cross(a, b);
 
         return 0.5 * std::sqrt(c.x * c.x + c.y * c.y + c.z * c.z);
     }
 
-    double calculate_surface_area(std::shared_ptr<mesh::MeshLayout> const& layout) {
-        auto triangulation_strategy = std::make_shared<mesh::DummyTriangulationStrategy>();
-        auto layout_reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+    // Fan strategies are made on the fly by TriangleRange, the others read the cached triangulation of the layout.
+    // The callback returns false to stop at the triangle
+    template<typename Callback>
+    static void for_each_triangle(
+        mesh::MeshLayout const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads,
+        Callback const& callback
+    ) {
+        if (triangulation_strategy.is_fan()) {
+            for (auto const& triangle : mesh::TriangleRange(layout)) {
+                if (!callback(triangle)) {
+                    return;
+                }
+            }
+
+            return;
+        }
+
+        const auto triangulation = layout.triangulation(triangulation_strategy, threads);
+
+        for (size_t i = 0; i < triangulation->size(); i++) {
+            if (!callback(triangulation->get_triangle(layout, i))) {
+                return;
+            }
+        }
+    }
+
+    template<typename Callback>
+    static void for_each_triangle(stl_file::StlTriangleView const& triangles, Callback const& callback) {
+        for (size_t i = 0; i < triangles.size(); i++) {
+            if (!callback(triangles.get_triangle(i))) {
+                return;
+            }
+        }
+    }
+
+    // for_each(callback) passes the triangles of the mesh to the callback
+    template<typename ForEach>
+    static double sum_surface_area(ForEach const& for_each) {
         double surface = 0;
 
-        for (auto const& triangle : layout_reader->triangles()) {
+        for_each([&surface](mesh::Triangle const& triangle) {
             surface += triangle_area(triangle);
-        }
+            return true;
+        });
 
         return surface;
     }
 
+    double calculate_surface_area(std::shared_ptr<mesh::MeshLayout> const& layout) {
+        mesh::FanTriangulationStrategy triangulation_strategy;
+        return calculate_surface_area(layout, triangulation_strategy);
+    }
+
+    // Triangulation of other strategies than the fan is shared by all the calculations on the same layout,
+    // only the first one triangulates
+    double calculate_surface_area(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads
+    ) {
+        return sum_surface_area([&](auto const& callback) {
+            for_each_triangle(*layout, triangulation_strategy, threads, callback);
+        });
+    }
+
+    double calculate_surface_area(stl_file::StlTriangleView const& triangles) {
+        return sum_surface_area([&](auto const& callback) {
+            for_each_triangle(triangles, callback);
+        });
+    }
+
     // Calculate volume refs:
     //   https://stackoverflow.com/questions/1406029/how-to-calculate-the-volume-of-a-3d-mesh-object-the-surface-of-which-is-made-up-t
     //   http://chenlab.ece.cornell.edu/Publication/Cha/icip01_Cha.pdf
     static double signed_volume_of_triangle(mesh::Triangle const& triangle) {
-        const auto v321 = triangle.vertices[2].x * triangle.vertices[1].y * triangle.vertices[0].z;
-        const auto v231 = triangle.vertices[1].x * triangle.vertices[2].y * triangle.vertices[0].z;
-        const auto v312 = triangle.vertices[2].x * triangle.vertices[0].y * triangle.vertices[1].z;
-        const auto v132 = triangle.vertices[0].x * triangle.vertices[2].y * triangle.vertices[1].z;
-        const auto v213 = triangle.vertices[1].x * triangle.vertices[0].y * triangle.vertices[2].z;
-        const auto v123 = triangle.vertices[0].x * triangle.vertices[1].y * triangle.vertices[2].z;
+        const auto v321 = triangle.vertices()[2].x * triangle.vertices()[1].y * triangle.vertices()[0].z;
+        const auto v231 = triangle.vertices()[1].x * triangle.vertices()[2].y * triangle.vertices()[0].z;
+        const auto v312 = triangle.vertices()[2].x * triangle.vertices()[0].y * triangle.vertices()[1].z;
+        const auto v132 = triangle.vertices()[0].x * triangle.vertices()[2].y * triangle.vertices()[1].z;
+        const auto v213 = triangle.vertices()[1].x * triangle.vertices()[0].y * triangle.vertices()[2].z;
+        const auto v123 = triangle.vertices()[0].x * triangle.vertices()[1].y * triangle.vertices()[2].z;
 
         return (1.0f/6.0f) * (-v321 + v231 + v312 - v132 - v213 + v123);
     }
 
-    double calculate_volume(std::shared_ptr<mesh::MeshLayout> const& layout) {
-        auto triangulation_strategy = std::make_shared<mesh::DummyTriangulationStrategy>();
-        auto layout_reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+    template<typename ForEach>
+    static double sum_volume(ForEach const& for_each) {
         double volume = 0;
 
-        for (auto const& triangle : layout_reader->triangles()) {
+        for_each([&volume](mesh::Triangle const& triangle) {
             volume += signed_volume_of_triangle(triangle);
-        }
+            return true;
+        });
 
         return volume;
     }
 
+    double calculate_volume(std::shared_ptr<mesh::MeshLayout> const& layout) {
+        mesh::FanTriangulationStrategy triangulation_strategy;
+        return calculate_volume(layout, triangulation_strategy);
+    }
+
+    double calculate_volume(
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads
+    ) {
+        return sum_volume([&](auto const& callback) {
+            for_each_triangle(*layout, triangulation_strategy, threads, callback);
+        });
+    }
+
+    double calculate_volume(stl_file::StlTriangleView const& triangles) {
+        return sum_volume([&](auto const& callback) {
+            for_each_triangle(triangles, callback);
+        });
+    }
+
     static double signed_volume(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d) {
         return (1.0f/6.0f) * glm::dot(glm::cross(b-a, c-a), d-a);
     }
 
     static double signed_volume(glm::vec3 point, mesh::Triangle const& triangle) {
-        return signed_volume(point, triangle.vertices[0], triangle.vertices[1], triangle.vertices[2]);
+        return signed_volume(point, triangle.vertices()[0], triangle.vertices()[1], triangle.vertices()[2]);
     }
 
     static bool eq_sign(double v1, double v2) {
@@ -123,27 +475,48 @@ namespace calc {
 
         const auto v1 = signed_volume(q1, triangle);
         const auto v2 = signed_volume(q2, triangle);
-        const auto v3 = signed_volume(q1, q2, triangle.vertices[0], triangle.vertices[1]);
-        const auto v4 = signed_volume(q1, q2, triangle.vertices[1], triangle.vertices[2]);
-        const auto v5 = signed_volume(q1, q2, triangle.vertices[2], triangle.vertices[0]);
+        const auto v3 = signed_volume(q1, q2, triangle.vertices()[0], triangle.vertices()[1]);
+        const auto v4 = signed_volume(q1, q2, triangle.vertices()[1], triangle.vertices()[2]);
+        const auto v5 = signed_volume(q1, q2, triangle.vertices()[2], triangle.vertices()[0]);
 
         return !eq_sign(v1, v2) && eq_sign(v3, v4) && eq_sign(v3, v5);
     }
 
-    bool is_point_inside_mesh(glm::vec3 point, std::shared_ptr<mesh::MeshLayout> const& layout) {
-        auto triangulation_strategy = std::make_shared<mesh::DummyTriangulationStrategy>();
-        auto layout_reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+    template<typename ForEach>
+    static bool is_point_behind_triangles(glm::vec3 point, ForEach const& for_each) {
+        bool behind = true;
 
-        for (auto const& triangle : layout_reader->triangles()) {
+        for_each([&](mesh::Triangle const& triangle) {
             const auto n = utils::calculate_normal(triangle);
-            const auto dist = glm::dot(n, point - triangle.vertices[0]);
+            const auto dist = glm::dot(n, point - triangle.vertices()[0]);
 
-            if (dist > 0) {
-                return false;
-            }
-        }
+            behind = !(dist > 0);
+            return behind;
+        });
 
-        return true;
+        return behind;
+    }
+
+    bool is_point_inside_mesh(glm::vec3 point, std::shared_ptr<mesh::MeshLayout> const& layout) {
+        mesh::FanTriangulationStrategy triangulation_strategy;
+        return is_point_inside_mesh(point, layout, triangulation_strategy);
+    }
+
+    bool is_point_inside_mesh(
+        glm::vec3 point,
+        std::shared_ptr<mesh::MeshLayout> const& layout,
+        mesh::TriangulationStrategy& triangulation_strategy,
+        size_t threads
+    ) {
+        return is_point_behind_triangles(point, [&](auto const& callback) {
+            for_each_triangle(*layout, triangulation_strategy, threads, callback);
+        });
+    }
+
+    bool is_point_inside_mesh(glm::vec3 point, stl_file::StlTriangleView const& triangles) {
+        return is_point_behind_triangles(point, [&](auto const& callback) {
+            for_each_triangle(triangles, callback);
+        });
     }
 
 }
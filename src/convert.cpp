@@ -0,0 +1,125 @@
+#include "convert.hpp"
+
+#include <cstdio>
+
+#include "obj.hpp"
+#include "stl.hpp"
+#include "utils.hpp"
+#include "transform.hpp"
+
+namespace convert {
+
+    class StlStreamHandler : public obj_file::ObjHandler {
+    public:
+        StlStreamHandler(
+            stl_file::StlStreamWriter& writer,
+            glm::mat4 const& transform,
+            mesh::TriangulationStrategy& triangulation_strategy
+        ) :
+            writer(writer),
+            point_matrix(transform::get_point_matrix(transform)),
+            identity(transform == glm::mat4(1)),
+            triangulation_strategy(triangulation_strategy)
+        {
+            // Nothing
+        }
+
+        void on_vertex(glm::vec3 const& v) override {
+            // Rounded like calc::apply_transforms_to_layout, both write the same stl. Like there, the identity
+            // keeps the vertices as they are, transforming would turn -0 into 0
+            this->vertices.push_back(this->identity ? v : transform::transform_point(this->point_matrix, v));
+        }
+
+        void on_face(std::vector<obj_file::Triplet> const& triplets) override {
+            for (auto const& triplet : triplets) {
+                if (triplet.v == 0 || triplet.v > this->vertices.size()) {
+                    throw mesh::ValidationException();
+                }
+            }
+
+            // The fan is made of the triplets straight away, nothing is allocated per face
+            if (this->triangulation_strategy.is_fan()) {
+                for (size_t corner = 1; corner + 1 < triplets.size(); corner++) {
+                    this->writer.write_triangle(mesh::Triangle(
+                        {get_vertex(triplets[0]), get_vertex(triplets[corner]), get_vertex(triplets[corner + 1])},
+                        std::nullopt,
+                        std::nullopt,
+                        std::nullopt
+                    ));
+                }
+
+                return;
+            }
+
+            this->polygon_vertices.clear();
+
+            for (auto const& triplet : triplets) {
+                this->polygon_vertices.push_back(get_vertex(triplet));
+            }
+
+            auto polygon = mesh::Polygon(std::move(this->polygon_vertices), std::nullopt, std::nullopt, std::nullopt);
+
+            this->triangles.clear();
+            this->triangulation_strategy.triangulate_into(polygon, this->triangles);
+
+            // Handed back, so the next face reuses its capacity
+            this->polygon_vertices = std::move(polygon).release_vertices();
+
+            for (auto const& triangle : this->triangles) {
+                this->writer.write_triangle(triangle);
+            }
+        }
+
+        [[nodiscard]] bool empty() const {
+            return this->vertices.empty();
+        }
+
+    private:
+        stl_file::StlStreamWriter& writer;
+        transform::AffineMatrix point_matrix;
+        bool identity;
+        std::vector<glm::vec3> vertices;
+        mesh::TriangulationStrategy& triangulation_strategy;
+
+        // Reused across faces
+        std::vector<glm::vec3> polygon_vertices;
+        std::vector<mesh::Triangle> triangles;
+
+        [[nodiscard]] glm::vec3 const& get_vertex(obj_file::Triplet const& triplet) const {
+            return this->vertices[triplet.v - 1];
+        }
+    };
+
+    void stream_obj_to_stl(std::string const& input, std::string const& output, glm::mat4 const& transform) {
+        mesh::FanTriangulationStrategy triangulation_strategy;
+        stream_obj_to_stl(input, output, transform, triangulation_strategy);
+    }
+
+    void stream_obj_to_stl(
+        std::string const& input,
+        std::string const& output,
+        glm::mat4 const& transform,
+        mesh::TriangulationStrategy& triangulation_strategy
+    ) {
+        const utils::MappedFile file(input);
+
+        try {
+            stl_file::StlStreamWriter writer(output);
+            StlStreamHandler handler(writer, transform, triangulation_strategy);
+
+            obj_file::stream_from_string(file.view(), handler);
+
+            if (handler.empty()) {
+                throw obj_file::StructIsException();
+            }
+
+            writer.finish();
+        }
+        catch (...) {
+            // Don't leave truncated stl behind
+            std::remove(output.c_str());
+            throw;
+        }
+    }
+
+}
@@ -0,0 +1,737 @@
+#include "mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mesh {
+
+    // Single ring port of earcut (https://github.com/mapbox/earcut): ears are clipped from a doubly
+    // linked ring, for large rings points that could lie inside an ear are looked up in a uniform grid
+    // of about a point per cell, so the cost stays close to O(n) instead of O(n^2)
+    static constexpr size_t hashed_ring_size = 80;
+
+    struct EarNode {
+        size_t corner;
+        double x;
+        double y;
+        EarNode* prev = nullptr;
+        EarNode* next = nullptr;
+        EarNode* next_in_cell = nullptr;
+
+        // Position of the latest candidates entry, earlier entries of the node are stale
+        size_t candidate = 0;
+        bool removed = false;
+    };
+
+    // Negative for a convex corner of a counterclockwise ring
+    static double area(EarNode const* p, EarNode const* q, EarNode const* r) {
+        return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+    }
+
+    static bool equals(EarNode const* p, EarNode const* q) {
+        return p->x == q->x && p->y == q->y;
+    }
+
+    // Squared
+    static double distance(EarNode const* p, EarNode const* q) {
+        return (p->x - q->x) * (p->x - q->x) + (p->y - q->y) * (p->y - q->y);
+    }
+
+    static int sign(double value) {
+        return value > 0 ? 1 : (value < 0 ? -1 : 0);
+    }
+
+    static bool point_in_triangle(
+        double ax, double ay,
+        double bx, double by,
+        double cx, double cy,
+        double px, double py
+    ) {
+        return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+            (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+            (bx - px) * (cy - py) >= (cx - px) * (by - py);
+    }
+
+    // q lies on the segment pr, given the three are collinear
+    static bool on_segment(EarNode const* p, EarNode const* q, EarNode const* r) {
+        return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) &&
+            q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+    }
+
+    static bool intersects(EarNode const* p1, EarNode const* q1, EarNode const* p2, EarNode const* q2) {
+        const auto o1 = sign(area(p1, q1, p2));
+        const auto o2 = sign(area(p1, q1, q2));
+        const auto o3 = sign(area(p2, q2, p1));
+        const auto o4 = sign(area(p2, q2, q1));
+
+        if (o1 != o2 && o3 != o4) return true;
+        if (o1 == 0 && on_segment(p1, p2, q1)) return true;
+        if (o2 == 0 && on_segment(p1, q2, q1)) return true;
+        if (o3 == 0 && on_segment(p2, p1, q2)) return true;
+        if (o4 == 0 && on_segment(p2, q1, q2)) return true;
+
+        return false;
+    }
+
+    static bool intersects_ring(EarNode const* a, EarNode const* b) {
+        auto p = a;
+
+        do {
+            if (p->corner != a->corner && p->next->corner != a->corner &&
+                p->corner != b->corner && p->next->corner != b->corner &&
+                intersects(p, p->next, a, b))
+            {
+                return true;
+            }
+
+            p = p->next;
+        } while (p != a);
+
+        return false;
+    }
+
+    // The diagonal ab starts inside the ring at a
+    static bool locally_inside(EarNode const* a, EarNode const* b) {
+        if (area(a->prev, a, a->next) < 0) {
+            return area(a, b, a->next) >= 0 && area(a, a->prev, b) >= 0;
+        }
+
+        return area(a, b, a->prev) < 0 || area(a, a->next, b) < 0;
+    }
+
+    static bool middle_inside(EarNode const* a, EarNode const* b) {
+        const double px = (a->x + b->x) / 2;
+        const double py = (a->y + b->y) / 2;
+
+        auto p = a;
+        bool inside = false;
+
+        do {
+            if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+                (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x))
+            {
+                inside = !inside;
+            }
+
+            p = p->next;
+        } while (p != a);
+
+        return inside;
+    }
+
+    static bool is_valid_diagonal(EarNode const* a, EarNode const* b) {
+        if (a->next->corner == b->corner || a->prev->corner == b->corner || intersects_ring(a, b)) {
+            return false;
+        }
+
+        const auto inside = locally_inside(a, b) && locally_inside(b, a) && middle_inside(a, b) &&
+            (area(a->prev, a, b->prev) != 0 || area(a, b->prev, b) != 0);
+
+        // Or a zero length diagonal between two copies of a point, with both corners convex
+        return inside || (equals(a, b) && area(a->prev, a, a->next) > 0 && area(b->prev, b, b->next) > 0);
+    }
+
+    static void remove_node(EarNode* p) {
+        p->removed = true;
+        p->next->prev = p->prev;
+        p->prev->next = p->next;
+    }
+
+    // Widens [x0, x1] by the part of the edge p q between y0 and y1
+    static void extend_row_span(EarNode const* p, EarNode const* q, double y0, double y1, double& x0, double& x1) {
+        auto t0 = 0.0;
+        auto t1 = 1.0;
+
+        if (p->y == q->y) {
+            if (p->y < y0 || p->y > y1) {
+                return;
+            }
+        }
+        else {
+            const auto ta = (y0 - p->y) / (q->y - p->y);
+            const auto tb = (y1 - p->y) / (q->y - p->y);
+
+            t0 = std::max(0.0, std::min(ta, tb));
+            t1 = std::min(1.0, std::max(ta, tb));
+
+            if (t0 > t1) {
+                return;
+            }
+        }
+
+        const auto xa = p->x + (q->x - p->x) * t0;
+        const auto xb = p->x + (q->x - p->x) * t1;
+
+        x0 = std::min({x0, xa, xb});
+        x1 = std::max({x1, xa, xb});
+    }
+
+    class EarClipper {
+    public:
+        EarClipper(
+            std::vector<EarNode>& nodes,
+            std::vector<EarNode*>& cells,
+            std::vector<EarNode*>& candidates,
+            std::vector<size_t>& triangles
+        ) :
+            nodes(nodes),
+            candidates(candidates),
+            triangles(triangles),
+            cells(cells)
+        {
+            // Nothing
+        }
+
+        // Appends corner triples with the winding of the points order
+        void triangulate(std::vector<glm::dvec2> const& points) {
+            // Splits run along non crossing diagonals, so a simple polygon has less of them than points
+            // and every split adds two nodes: the nodes never reallocate and the links stay valid
+            this->nodes.clear();
+            this->nodes.reserve(3 * points.size());
+
+            auto ring = this->link_ring(points);
+
+            if (!ring || ring->next == ring->prev) {
+                return;
+            }
+
+            this->cells.clear();
+
+            if (points.size() > hashed_ring_size) {
+                this->index_cells(ring, points);
+            }
+
+            this->clip_ears(ring, 0);
+        }
+
+    private:
+        std::vector<EarNode>& nodes;
+        std::vector<EarNode*>& candidates;
+        std::vector<size_t>& triangles;
+
+        // Heads of the lists of nodes in every cell, row by row, empty when the ring is too small
+        // to be worth hashing. Removed nodes stay in their cells and are skipped
+        std::vector<EarNode*>& cells;
+        size_t columns = 0;
+        size_t rows = 0;
+        double min_x = 0;
+        double min_y = 0;
+        double inv_cell_width = 0;
+        double inv_cell_height = 0;
+
+        // Clipping treats the ring as counterclockwise, a clockwise one is linked backwards
+        // and its triangles are flipped back on output
+        bool reversed = false;
+
+        EarNode* insert_node(size_t corner, double x, double y, EarNode* last) {
+            assert(this->nodes.size() < this->nodes.capacity());
+            auto p = &this->nodes.emplace_back(EarNode {corner, x, y});
+
+            if (!last) {
+                p->prev = p;
+                p->next = p;
+            }
+            else {
+                p->next = last->next;
+                p->prev = last;
+                last->next->prev = p;
+                last->next = p;
+            }
+
+            return p;
+        }
+
+        EarNode* link_ring(std::vector<glm::dvec2> const& points) {
+            double signed_area = 0;
+
+            for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+                signed_area += (points[j].x - points[i].x) * (points[i].y + points[j].y);
+            }
+
+            this->reversed = signed_area <= 0;
+            EarNode* last = nullptr;
+
+            for (size_t k = 0; k < points.size(); k++) {
+                const auto i = this->reversed ? points.size() - 1 - k : k;
+                last = this->insert_node(i, points[i].x, points[i].y, last);
+            }
+
+            if (last && equals(last, last->next)) {
+                remove_node(last);
+                last = last->next;
+            }
+
+            return last;
+        }
+
+        void push_triangle(EarNode const* a, EarNode const* b, EarNode const* c) {
+            if (this->reversed) {
+                std::swap(a, c);
+            }
+
+            this->triangles.push_back(a->corner);
+            this->triangles.push_back(b->corner);
+            this->triangles.push_back(c->corner);
+        }
+
+        // Removes duplicate and collinear points
+        static EarNode* filter_points(EarNode* start, EarNode* end = nullptr) {
+            if (!start) {
+                return start;
+            }
+
+            if (!end) {
+                end = start;
+            }
+
+            auto p = start;
+            bool again;
+
+            do {
+                again = false;
+
+                if (equals(p, p->next) || area(p->prev, p, p->next) == 0) {
+                    remove_node(p);
+                    p = end = p->prev;
+
+                    if (p == p->next) {
+                        break;
+                    }
+
+                    again = true;
+                }
+                else {
+                    p = p->next;
+                }
+            } while (again || p != end);
+
+            return end;
+        }
+
+        // Passes: 0 plain clipping, 1 after filtering points, 2 after curing local self intersections,
+        // then the ring is split in two along a valid diagonal
+        void clip_ears(EarNode* ear, int pass) {
+            if (!ear) {
+                return;
+            }
+
+            // The first round visits the ring in order, later rounds only the neighbours of clipped ears,
+            // so a ring with ears left at one spot doesn't walk all of its points for every ear.
+            // Neighbours move behind the queue, which skips the next one like earcut does in the first round
+            auto clipped = true;
+
+            while (clipped) {
+                clipped = false;
+                this->candidates.clear();
+
+                auto p = ear;
+
+                do {
+                    this->push_candidate(p);
+                    p = p->next;
+                } while (p != ear);
+
+                for (size_t i = 0; i < this->candidates.size(); i++) {
+                    const auto node = this->candidates[i];
+
+                    if (node->removed || node->candidate != i) {
+                        continue;
+                    }
+
+                    if (node->prev == node->next) {
+                        return;
+                    }
+
+                    ear = node;
+                    const auto prev = node->prev;
+                    const auto next = node->next;
+
+                    if (!this->cells.empty() ? this->is_ear_hashed(node) : is_ear(node)) {
+                        this->push_triangle(prev, node, next);
+                        remove_node(node);
+
+                        // The neighbour leaving the shorter diagonal goes first, as in a triangle strip,
+                        // else a fan of long slivers can grow out of one of them
+                        if (distance(prev, next->next) < distance(prev->prev, next)) {
+                            this->push_candidate(next);
+                            this->push_candidate(prev);
+                        }
+                        else {
+                            this->push_candidate(prev);
+                            this->push_candidate(next);
+                        }
+
+                        ear = next;
+                        clipped = true;
+                    }
+                }
+            }
+
+            if (ear->prev == ear->next) {
+                return;
+            }
+
+            if (pass == 0) {
+                this->clip_ears(filter_points(ear), 1);
+            }
+            else if (pass == 1) {
+                ear = this->cure_local_intersections(filter_points(ear));
+                this->clip_ears(ear, 2);
+            }
+            else {
+                this->split_ring(ear);
+            }
+        }
+
+        void push_candidate(EarNode* node) {
+            node->candidate = this->candidates.size();
+            this->candidates.push_back(node);
+        }
+
+        static bool is_ear(EarNode const* ear) {
+            const auto a = ear->prev;
+            const auto b = ear;
+            const auto c = ear->next;
+
+            if (area(a, b, c) >= 0) {
+                return false;
+            }
+
+            const auto x0 = std::min({a->x, b->x, c->x});
+            const auto y0 = std::min({a->y, b->y, c->y});
+            const auto x1 = std::max({a->x, b->x, c->x});
+            const auto y1 = std::max({a->y, b->y, c->y});
+
+            for (auto p = c->next; p != a; p = p->next) {
+                if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+                    point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                    area(p->prev, p, p->next) >= 0)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool is_ear_hashed(EarNode const* ear) const {
+            const auto a = ear->prev;
+            const auto b = ear;
+            const auto c = ear->next;
+
+            if (area(a, b, c) >= 0) {
+                return false;
+            }
+
+            const auto x0 = std::min({a->x, b->x, c->x});
+            const auto y0 = std::min({a->y, b->y, c->y});
+            const auto x1 = std::max({a->x, b->x, c->x});
+            const auto y1 = std::max({a->y, b->y, c->y});
+
+            const auto row0 = this->get_row(y0);
+            const auto row1 = this->get_row(y1);
+
+            for (size_t row = row0; row <= row1; row++) {
+                // Only the columns the triangle covers within the row, long diagonal ears have
+                // bounding boxes much larger than themselves
+                const auto row_y0 = this->inv_cell_height != 0 ? std::max(y0, this->min_y + double(row) / this->inv_cell_height) : y0;
+                const auto row_y1 = this->inv_cell_height != 0 ? std::min(y1, this->min_y + double(row + 1) / this->inv_cell_height) : y1;
+                auto row_x0 = x1;
+                auto row_x1 = x0;
+
+                extend_row_span(a, b, row_y0, row_y1, row_x0, row_x1);
+                extend_row_span(b, c, row_y0, row_y1, row_x0, row_x1);
+                extend_row_span(c, a, row_y0, row_y1, row_x0, row_x1);
+
+                if (row_x0 > row_x1) {
+                    continue;
+                }
+
+                // A column either way covers points rounded into a neighbouring cell
+                const auto column0 = std::max(this->get_column(row_x0), size_t(1)) - 1;
+                const auto column1 = std::min(this->get_column(row_x1) + 1, this->columns - 1);
+
+                for (size_t column = column0; column <= column1; column++) {
+                    for (auto p = this->cells[row * this->columns + column]; p; p = p->next_in_cell) {
+                        // Copies made by splits share the coordinates of the diagonal ends
+                        if (!p->removed && p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+                            !equals(p, a) && !equals(p, c) &&
+                            point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                            area(p->prev, p, p->next) >= 0)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        EarNode* cure_local_intersections(EarNode* start) {
+            auto p = start;
+
+            do {
+                const auto a = p->prev;
+                const auto b = p->next->next;
+
+                if (!equals(a, b) && intersects(a, p, p->next, b) && locally_inside(a, b) && locally_inside(b, a)) {
+                    this->push_triangle(a, p, b);
+
+                    remove_node(p);
+                    remove_node(p->next);
+
+                    p = start = b;
+                }
+
+                p = p->next;
+            } while (p != start);
+
+            return filter_points(p);
+        }
+
+        void split_ring(EarNode* start) {
+            auto a = start;
+
+            do {
+                for (auto b = a->next->next; b != a->prev; b = b->next) {
+                    if (a->corner != b->corner && is_valid_diagonal(a, b)) {
+                        // Only a badly self intersecting face runs out of nodes, it's left partly triangulated
+                        if (this->nodes.size() + 2 > this->nodes.capacity()) {
+                            return;
+                        }
+
+                        auto c = this->split(a, b);
+
+                        a = filter_points(a, a->next);
+                        c = filter_points(c, c->next);
+
+                        this->clip_ears(a, 0);
+                        this->clip_ears(c, 0);
+                        return;
+                    }
+                }
+
+                a = a->next;
+            } while (a != start);
+        }
+
+        // Links a to b by a diagonal, the ring falls apart in two: one through a and b and one through their copies
+        EarNode* split(EarNode* a, EarNode* b) {
+            auto a2 = &this->nodes.emplace_back(EarNode {a->corner, a->x, a->y});
+            auto b2 = &this->nodes.emplace_back(EarNode {b->corner, b->x, b->y});
+
+            if (!this->cells.empty()) {
+                this->insert_into_cell(a2);
+                this->insert_into_cell(b2);
+            }
+
+            auto an = a->next;
+            auto bp = b->prev;
+
+            a->next = b;
+            b->prev = a;
+
+            a2->next = an;
+            an->prev = a2;
+
+            b2->next = a2;
+            a2->prev = b2;
+
+            bp->next = b2;
+            b2->prev = bp;
+
+            return b2;
+        }
+
+        [[nodiscard]] size_t get_column(double x) const {
+            return std::min(this->columns - 1, size_t((x - this->min_x) * this->inv_cell_width));
+        }
+
+        [[nodiscard]] size_t get_row(double y) const {
+            return std::min(this->rows - 1, size_t((y - this->min_y) * this->inv_cell_height));
+        }
+
+        void insert_into_cell(EarNode* node) {
+            auto& cell = this->cells[this->get_row(node->y) * this->columns + this->get_column(node->x)];
+            node->next_in_cell = cell;
+            cell = node;
+        }
+
+        // Cells follow the aspect of the bounding box, so thin faces get a row or a column of cells
+        void index_cells(EarNode* start, std::vector<glm::dvec2> const& points) {
+            auto max_x = points[0].x;
+            auto max_y = points[0].y;
+            this->min_x = points[0].x;
+            this->min_y = points[0].y;
+
+            for (auto const& point : points) {
+                this->min_x = std::min(this->min_x, point.x);
+                this->min_y = std::min(this->min_y, point.y);
+                max_x = std::max(max_x, point.x);
+                max_y = std::max(max_y, point.y);
+            }
+
+            const auto width = max_x - this->min_x;
+            const auto height = max_y - this->min_y;
+            const auto count = double(points.size());
+
+            if (width == 0 || height == 0) {
+                this->columns = width == 0 ? 1 : points.size();
+            }
+            else {
+                this->columns = size_t(std::clamp(std::sqrt(count * width / height), 1.0, count));
+            }
+
+            this->rows = std::max<size_t>(1, points.size() / this->columns);
+            this->inv_cell_width = width != 0 ? double(this->columns) / width : 0;
+            this->inv_cell_height = height != 0 ? double(this->rows) / height : 0;
+            this->cells.assign(this->columns * this->rows, nullptr);
+
+            auto p = start;
+
+            do {
+                this->insert_into_cell(p);
+                p = p->next;
+            } while (p != start);
+        }
+    };
+
+    // Faces are planar, so they are triangulated in the coordinate plane most parallel to them:
+    // the one dropping the largest component of the Newell normal
+    static void project_to_dominant_plane(std::vector<glm::vec3> const& points, std::vector<glm::dvec2>& projected) {
+        glm::dvec3 normal(0);
+
+        for (size_t i = 0; i < points.size(); i++) {
+            const glm::dvec3 current(points[i]);
+            const glm::dvec3 next(points[(i + 1) % points.size()]);
+
+            normal.x += (current.y - next.y) * (current.z + next.z);
+            normal.y += (current.z - next.z) * (current.x + next.x);
+            normal.z += (current.x - next.x) * (current.y + next.y);
+        }
+
+        const auto abs_x = std::abs(normal.x);
+        const auto abs_y = std::abs(normal.y);
+        const auto abs_z = std::abs(normal.z);
+
+        projected.clear();
+        projected.reserve(points.size());
+
+        for (auto const& point : points) {
+            if (abs_z >= abs_x && abs_z >= abs_y) {
+                projected.emplace_back(point.x, point.y);
+            }
+            else if (abs_x >= abs_y) {
+                projected.emplace_back(point.y, point.z);
+            }
+            else {
+                projected.emplace_back(point.z, point.x);
+            }
+        }
+    }
+
+    EarClippingTriangulationStrategy::EarClippingTriangulationStrategy() = default;
+
+    EarClippingTriangulationStrategy::~EarClippingTriangulationStrategy() = default;
+
+    void EarClippingTriangulationStrategy::triangulate_points(std::vector<glm::vec3> const& points) {
+        this->corners.clear();
+
+        if (points.size() < 3) {
+            return;
+        }
+
+        if (points.size() == 3) {
+            this->corners.insert(this->corners.end(), {0, 1, 2});
+            return;
+        }
+
+        project_to_dominant_plane(points, this->projected);
+        EarClipper(this->nodes, this->cells, this->candidates, this->corners).triangulate(this->projected);
+    }
+
+    std::vector<Triangle> EarClippingTriangulationStrategy::triangulate(Polygon const& polygon) {
+        this->triangulate_points(polygon.vertices());
+
+        std::vector<Triangle> triangles;
+        triangles.reserve(this->corners.size() / 3);
+
+        for (size_t i = 0; i < this->corners.size(); i += 3) {
+            const std::array<size_t, 3> triangle_corners = {this->corners[i], this->corners[i + 1], this->corners[i + 2]};
+
+            std::optional<std::array<glm::vec3, 3>> normals;
+            std::optional<std::array<glm::vec2, 3>> tex_coords;
+            std::array<glm::vec3, 3> vertices;
+
+            for (size_t k = 0; k < 3; k++) {
+                vertices[k] = polygon.vertices()[triangle_corners[k]];
+            }
+
+            if (polygon.normals()) {
+                normals.emplace();
+
+                for (size_t k = 0; k < 3; k++) {
+                    (*normals)[k] = polygon.normals().value()[triangle_corners[k]];
+                }
+            }
+
+            if (polygon.tex_coords()) {
+                tex_coords.emplace();
+
+                for (size_t k = 0; k < 3; k++) {
+                    (*tex_coords)[k] = polygon.tex_coords().value()[triangle_corners[k]];
+                }
+            }
+
+            triangles.emplace_back(vertices, normals, tex_coords, std::nullopt);
+        }
+
+        return triangles;
+    }
+
+    void EarClippingTriangulationStrategy::triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) {
+        this->triangulate_face_points(layout, face);
+
+        const auto first = layout.faces().offsets[face];
+
+        for (const auto corner : this->corners) {
+            corners.push_back(first + index_t(corner));
+        }
+    }
+
+    size_t EarClippingTriangulationStrategy::triangulate_face_into(MeshLayout const& layout, size_t face, index_t* corners) {
+        this->triangulate_face_points(layout, face);
+
+        const auto first = layout.faces().offsets[face];
+
+        // A triangle takes at least one corner off the ring, so there are never more than n - 2
+        assert(this->points.size() >= 3 || this->corners.empty());
+        assert(this->corners.size() <= 3 * (this->points.size() - 2));
+
+        for (const auto corner : this->corners) {
+            *corners++ = first + index_t(corner);
+        }
+
+        return this->corners.size() / 3;
+    }
+
+    std::unique_ptr<TriangulationStrategy> EarClippingTriangulationStrategy::clone() const {
+        return std::make_unique<EarClippingTriangulationStrategy>();
+    }
+
+    void EarClippingTriangulationStrategy::triangulate_face_points(MeshLayout const& layout, size_t face) {
+        auto const& faces = layout.faces();
+        const auto first = faces.offsets[face];
+        const auto last = faces.offsets[face + 1];
+
+        this->points.clear();
+
+        for (auto corner = first; corner < last; corner++) {
+            this->points.push_back(layout.vertices()[faces.vertices_indices[corner]]);
+        }
+
+        this->triangulate_points(this->points);
+    }
+
+}
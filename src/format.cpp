@@ -3,12 +3,29 @@
 namespace mesh_format {
 
     std::vector<char> MeshWriter::write(std::shared_ptr<mesh::MeshLayout> const& layout) {
-        auto triangulation_strategy = std::make_shared<mesh::DummyTriangulationStrategy>();
-        this->layout_reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+        MemorySink sink;
+        this->write(layout, sink);
+        return sink.release();
+    }
+
+    void MeshWriter::write(std::shared_ptr<mesh::MeshLayout> const& layout, OutputSink& sink) {
+        this->layout_reader = std::make_unique<mesh::MeshLayoutReader>(layout, this->triangulation_strategy, this->threads);
+        this->sink = &sink;
 
         this->writer->clear();
         this->write_layout();
-        return this->writer->get_data();
+        this->flush_to_sink(true);
+    }
+
+    void MeshWriter::flush_to_sink(bool force) {
+        auto const& bytes = this->writer->get_bytes();
+
+        if (bytes.empty() || (!force && bytes.size() < sink_chunk_size)) {
+            return;
+        }
+
+        this->sink->write(bytes.data(), bytes.size());
+        this->writer->clear();
     }
 
     void MeshWriter::write_vertices() {
@@ -28,7 +45,10 @@ namespace mesh_format {
     }
 
     void MeshWriter::write_triangles() {
-        this->write_triangles(this->layout_reader->triangles());
+        this->layout_reader->for_each_triangle([this](mesh::Triangle const& triangle) {
+            this->write_triangle(triangle);
+            this->flush_to_sink();
+        });
     }
 
     void MeshWriter::write_polygons() {
@@ -38,36 +58,42 @@ namespace mesh_format {
     void MeshWriter::write_vertices(std::vector<glm::vec3> const& vertices) {
         for (auto vertex : vertices) {
             this->write_vertex(vertex);
+            this->flush_to_sink();
         }
     }
 
     void MeshWriter::write_normals(std::vector<glm::vec3> const& normals) {
         for (auto normal : normals) {
             this->write_normal(normal);
+            this->flush_to_sink();
         }
     }
 
     void MeshWriter::write_tex_coords(std::vector<glm::vec2> const& tex_coords) {
         for (auto tex_coord : tex_coords) {
             this->write_tex_coord(tex_coord);
+            this->flush_to_sink();
         }
     }
 
     void MeshWriter::write_triplets(std::vector<mesh::Triplet> const& triplets) {
         for (auto triplet : triplets) {
             this->write_triplet(triplet);
+            this->flush_to_sink();
         }
     }
 
     void MeshWriter::write_triangles(std::vector<mesh::Triangle> const& triangles) {
-        for (auto triangle : triangles) {
+        for (auto const& triangle : triangles) {
             this->write_triangle(triangle);
+            this->flush_to_sink();
         }
     }
 
     void MeshWriter::write_polygons(std::vector<mesh::Polygon> const& polygons) {
         for (auto const& polygon : polygons) {
             this->write_polygon(polygon);
+            this->flush_to_sink();
         }
     }
 
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <thread>
+#include <algorithm>
+#include <cctype>
 
 #include <glm/glm.hpp>
 
@@ -9,16 +12,43 @@
 #include "stl.hpp"
 #include "utils.hpp"
 #include "calc.hpp"
+#include "convert.hpp"
+#include "mesh_cache.hpp"
 
 namespace fs = std::filesystem;
 
-static void save_to_stl(std::vector<char> const& out_bytes, std::string const& output);
+enum class CacheMode {
+    Use,
+    Rebuild,
+    Disabled,
+};
 
-static std::shared_ptr<mesh::MeshLayout> load_mesh_layout(std::string const& input) {
+static void save_mesh_cache(std::string const& input, mesh_cache::SourceKey const& key, mesh::MeshLayout const& layout) {
     try {
-        auto lines = utils::load_text_file_lines(input);
-        auto obj = obj_file::load_from_string_lines(lines);
-        return obj_file::create_mesh_layout_from_obj(obj);
+        mesh_cache::save(input, key, layout);
+    }
+    catch (std::exception const& e) {
+        std::cout << "Saving mesh cache '" << mesh_cache::get_cache_path(input) << "' failed." << std::endl;
+    }
+}
+
+static std::shared_ptr<mesh::MeshLayout> load_mesh_layout(std::string const& input, size_t threads, CacheMode cache_mode) {
+    try {
+        if (cache_mode == CacheMode::Disabled) {
+            return obj_file::load_mesh_layout_from_file(input, threads);
+        }
+
+        const auto key = mesh_cache::get_source_key(input);
+
+        if (cache_mode == CacheMode::Use) {
+            if (auto layout = mesh_cache::load(input, key)) {
+                return layout;
+            }
+        }
+
+        auto layout = obj_file::load_mesh_layout_from_file(input, threads);
+        save_mesh_cache(input, key, *layout);
+        return layout;
     }
     catch (std::ifstream::failure const& e) {
         std::cout << "Opening file '" << input << "' failed, it either doesn't exist or is not accessible." << std::endl;
@@ -32,6 +62,31 @@ static std::shared_ptr<mesh::MeshLayout> load_mesh_layout(std::string const& inp
         std::cout << "Opening file '" << input << "' failed, struct model is empty." << std::endl;
         exit(1);
     }
+    catch (mesh::IndexOverflowException const& e) {
+        std::cout << "Opening file '" << input << "' failed, the mesh needs a build with ENABLE_64BIT_INDICES." << std::endl;
+        exit(1);
+    }
+}
+
+static bool is_stl_path(std::string const& path) {
+    auto extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char ch) { return std::tolower(ch); });
+
+    return extension == ".stl";
+}
+
+static std::unique_ptr<stl_file::StlTriangleView> load_stl_triangles(std::string const& input) {
+    try {
+        return std::make_unique<stl_file::StlTriangleView>(input);
+    }
+    catch (std::ifstream::failure const& e) {
+        std::cout << "Opening file '" << input << "' failed, it either doesn't exist or is not accessible." << std::endl;
+        exit(1);
+    }
+    catch (stl_file::ParseException const& e) {
+        std::cout << "Opening file '" << input << "' failed, parse error." << std::endl;
+        exit(1);
+    }
 }
 
 static void convert_from_obj_to_stl(
@@ -39,62 +94,116 @@ static void convert_from_obj_to_stl(
     std::string const& output,
     glm::vec3 const& transition,
     glm::vec3 const& rotations,
-    glm::vec3 const& scale
+    glm::vec3 const& scale,
+    std::shared_ptr<mesh::TriangulationStrategy> const& triangulation_strategy,
+    size_t threads,
+    bool ascii
 ) {
+    if (fs::exists(output)) {
+        std::cout << "File '" << output << "' already exists" << std::endl;
+        return;
+    }
+
     try {
         auto transformed_layout = calc::apply_transforms_to_layout(
             layout,
             transition,
             rotations,
-            scale
+            scale,
+            threads
         );
 
-        auto writer = std::make_unique<stl_file::StlMeshWriter>();
-        auto out_bytes = writer->write(transformed_layout);
+        // Triangles are written to the file as they are encoded, the output is never held in memory
+        mesh_format::FileSink sink(output);
+        std::unique_ptr<mesh_format::MeshWriter> writer;
+
+        if (ascii) {
+            writer = std::make_unique<stl_file::StlTextMeshWriter>(triangulation_strategy, threads);
+        }
+        else {
+            writer = std::make_unique<stl_file::StlMeshWriter>(triangulation_strategy, threads);
+        }
 
-        save_to_stl(out_bytes, output);
+        writer->write(transformed_layout, sink);
+        sink.close();
+
+        std::cout << "Successfully converted" << std::endl;
+    }
+    catch (std::ofstream::failure const& e) {
+        std::remove(output.c_str());
+        std::cout << "Saving to file '" << output << "' failed, i/o error." << std::endl;
     }
     catch (std::exception const& e) {
+        std::remove(output.c_str());
         std::cout << "Failed to convert file." << std::endl;
     }
 }
 
-static void save_to_stl(std::vector<char> const& out_bytes, std::string const& output) {
+static void stream_from_obj_to_stl(
+    std::string const& input,
+    std::string const& output,
+    glm::vec3 const& transition,
+    glm::vec3 const& rotations,
+    glm::vec3 const& scale,
+    mesh::TriangulationStrategy& triangulation_strategy
+) {
+    if (fs::exists(output)) {
+        std::cout << "File '" << output << "' already exists" << std::endl;
+        return;
+    }
+
     try {
-        std::ofstream outfile;
+        const auto transform = calc::create_transform_matrix(transition, rotations, scale);
+        convert::stream_obj_to_stl(input, output, transform, triangulation_strategy);
 
-        if (fs::exists(output)) {
-            std::cout << "File '" << output << "' already exists" << std::endl;
-        }
-        else {
-            outfile.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-            outfile.open(output, std::ios::out | std::ios::binary);
-            outfile.write(out_bytes.data(), out_bytes.size());
+        std::cout << "Successfully converted" << std::endl;
+    }
+    catch (std::ifstream::failure const& e) {
+        std::cout << "Converting file '" << input << "' to '" << output << "' failed, i/o error." << std::endl;
+    }
+    catch (std::exception const& e) {
+        std::cout << "Failed to convert file." << std::endl;
+    }
+}
 
-            std::cout << "Successfully converted" << std::endl;
-        }
+static std::shared_ptr<mesh::TriangulationStrategy> create_triangulation_strategy(std::string const& name) {
+    if (name == "fan") {
+        return std::make_shared<mesh::FanTriangulationStrategy>();
     }
-    catch (std::ofstream::failure const& e) {
-        std::cout << "Converted but save to file '" << output << "' failed." << std::endl;
+
+    if (name == "ear_clipping") {
+        return std::make_shared<mesh::EarClippingTriangulationStrategy>();
     }
+
+    std::cout << "Unknown triangulation '" << name << "', expected fan or ear_clipping" << std::endl;
+    exit(1);
 }
 
 int main(int argc, char **argv) {
     try {
-        cxxopts::Options options(argv[0], "Converter from .obj to .stl");
+        cxxopts::Options options(argv[0], "Converter from .obj or .stl to .stl");
 
         std::string input;
         std::string output;
+        std::string triangulation = "fan";
 
         glm::vec3 transition(0);
         glm::vec3 rotation(0);
         glm::vec3 scale(1);
         glm::vec3 point(0);
 
+        uint32_t threads = 0;
+
         bool convert_to_stl = false;
         bool test_point = false;
         bool surface_area = false;
         bool volume = false;
+        bool stream = false;
+        bool ascii = false;
+        bool weld = false;
+        float weld_grid = 0;
+        bool no_cache = false;
+        bool rebuild_cache = false;
 
         options
             .add_options()
@@ -104,6 +213,12 @@ int main(int argc, char **argv) {
             ("s,surface_area", "Calculate surface area", cxxopts::value<bool>(surface_area))
             ("v,volume", "Calculate volume (experimental)", cxxopts::value<bool>(volume))
             ("p,test_point", "Test whether point inside mesh or not (experimental)", cxxopts::value<bool>(test_point))
+            ("stream", "Convert in a single pass with bounded memory", cxxopts::value<bool>(stream))
+            ("ascii", "Write ascii stl instead of binary", cxxopts::value<bool>(ascii))
+            ("weld", "Share one vertex between corners at the same position", cxxopts::value<bool>(weld))
+            ("weld-grid", "Snap vertices to a grid of this cell size and weld the ones in a cell (default: 0, exact positions)", cxxopts::value<float>(weld_grid))
+            ("no-cache", "Don't read or write the <input>.meshcache file", cxxopts::value<bool>(no_cache))
+            ("rebuild-cache", "Parse the input even if the mesh cache is up to date and rewrite it", cxxopts::value<bool>(rebuild_cache))
 
             ("px", "Point x (default: 0)", cxxopts::value<float>(point.x))
             ("py", "Point y (default: 0)", cxxopts::value<float>(point.y))
@@ -121,7 +236,10 @@ int main(int argc, char **argv) {
             ("sy", "y scale (default: 1)", cxxopts::value<float>(scale.y))
             ("sz", "z scale (default: 1)", cxxopts::value<float>(scale.z))
 
-            ("i,input", "Input .obj file", cxxopts::value<std::string>(input))
+            ("j,threads", "Number of worker threads (default: number of cores)", cxxopts::value<uint32_t>(threads))
+            ("triangulation", "Triangulation of polygons: fan or ear_clipping, ear clipping handles concave faces (default: fan)", cxxopts::value<std::string>(triangulation))
+
+            ("i,input", "Input .obj or .stl file", cxxopts::value<std::string>(input))
             ("o,output", "Output .stl file", cxxopts::value<std::string>(output));
 
         auto result = options.parse(argc, argv);
@@ -141,29 +259,106 @@ int main(int argc, char **argv) {
             exit(1);
         }
 
-        auto mesh_layout = load_mesh_layout(input);
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
 
-        if (convert_to_stl) {
-            if (result.count("output") == 0) {
-                std::cout << "Output is required" << std::endl;
-                exit(1);
+        if (convert_to_stl && result.count("output") == 0) {
+            std::cout << "Output is required" << std::endl;
+            exit(1);
+        }
+
+        const bool stl_input = is_stl_path(input);
+
+        if (stream && stl_input) {
+            std::cout << "Only obj input can be converted with --stream" << std::endl;
+            exit(1);
+        }
+
+        // Calculations read stl triangles in place, there's no layout to weld without the conversion
+        if (stl_input && !convert_to_stl && (weld || result.count("weld-grid") != 0)) {
+            std::cout << "Stl vertices can only be welded with -c" << std::endl;
+            exit(1);
+        }
+
+        if (stream && weld) {
+            std::cout << "Vertices can't be welded with --stream" << std::endl;
+            exit(1);
+        }
+
+        if (stream && ascii) {
+            std::cout << "Ascii stl can't be written with --stream" << std::endl;
+            exit(1);
+        }
+
+        const auto triangulation_strategy = create_triangulation_strategy(triangulation);
+        auto cache_mode = CacheMode::Use;
+
+        if (no_cache) {
+            cache_mode = CacheMode::Disabled;
+        }
+        else if (rebuild_cache) {
+            cache_mode = CacheMode::Rebuild;
+        }
+
+        std::shared_ptr<mesh::MeshLayout> mesh_layout;
+
+        // Calculations read stl triangles in place, only the conversion needs a layout
+        std::unique_ptr<stl_file::StlTriangleView> stl_triangles;
+
+        if (stl_input) {
+            stl_triangles = load_stl_triangles(input);
+
+            // Stl corners are welded while the layout is built, --weld only sets the grid size
+            if (convert_to_stl) {
+                mesh_layout = stl_triangles->build_layout(threads, weld ? weld_grid : 0);
+            }
+
+            if (weld && mesh_layout) {
+                std::cout << "Welded " << 3 * stl_triangles->size() << " vertices into " << mesh_layout->vertices().size() << std::endl;
             }
+        }
+        else if ((convert_to_stl && !stream) || test_point || surface_area || volume) {
+            mesh_layout = load_mesh_layout(input, threads, cache_mode);
+        }
+
+        if (weld && mesh_layout && !stl_input) {
+            const auto vertices_count = mesh_layout->vertices().size();
+            mesh_layout = calc::weld_vertices(mesh_layout, weld_grid, threads);
 
-            convert_from_obj_to_stl(mesh_layout, output, transition, rotation, scale);
+            std::cout << "Welded " << vertices_count << " vertices into " << mesh_layout->vertices().size() << std::endl;
+        }
+
+        if (convert_to_stl) {
+            if (stream) {
+                stream_from_obj_to_stl(input, output, transition, rotation, scale, *triangulation_strategy);
+            }
+            else {
+                convert_from_obj_to_stl(mesh_layout, output, transition, rotation, scale, triangulation_strategy, threads, ascii);
+            }
         }
 
         if (surface_area) {
-            const auto area = calc::calculate_surface_area(mesh_layout);
+            const auto area = stl_triangles ?
+                calc::calculate_surface_area(*stl_triangles) :
+                calc::calculate_surface_area(mesh_layout, *triangulation_strategy, threads);
+
             std::cout << "Surface area is: " << area << std::endl;
         }
 
         if (volume) {
-            const auto volume = calc::calculate_volume(mesh_layout);
+            const auto volume = stl_triangles ?
+                calc::calculate_volume(*stl_triangles) :
+                calc::calculate_volume(mesh_layout, *triangulation_strategy, threads);
+
             std::cout << "Volume is: " << volume << std::endl;
         }
 
         if (test_point) {
-            const auto inside = calc::is_point_inside_mesh(point, mesh_layout);
+            const auto inside = stl_triangles ?
+                calc::is_point_inside_mesh(point, *stl_triangles) :
+                calc::is_point_inside_mesh(point, mesh_layout, *triangulation_strategy, threads);
+
             std::cout << "Point (" << point.x << ", " << point.y << ", " << point.z << ") ";
 
             if (inside) {
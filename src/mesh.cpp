@@ -1,43 +1,117 @@
 #include <algorithm>
-#include <numeric>
 #include <memory>
 #include "mesh.hpp"
 
 namespace mesh {
+    void check_index_capacity(size_t count) {
+        if (count > max_elements) {
+            throw IndexOverflowException();
+        }
+    }
+
     std::shared_ptr<MeshLayout> MeshLayoutBuilder::build() {
         this->validate_indices();
 
-        return std::make_shared<MeshLayout>(
-            this->vertices,
-            this->normals,
-            this->tex_coords,
-            this->colors,
-            this->faces
+        auto layout = std::make_shared<MeshLayout>(
+            std::move(this->vertices),
+            std::move(this->normals),
+            std::move(this->tex_coords),
+            std::move(this->colors),
+            std::move(this->faces)
         );
+
+        *this = MeshLayoutBuilder();
+        return layout;
     }
 
-    template<typename T>
-    static void validate_indices(
-        std::vector<size_t> const& indices,
-        std::vector<T> const& data
-    ) {
-        for (const auto index : indices) {
-            if (index == ::mesh::absent_index) {
-                continue;
+    void FaceTable::reserve(size_t faces, size_t indices) {
+        this->offsets.reserve(this->offsets.size() + faces);
+        this->vertices_indices.reserve(this->vertices_indices.size() + indices);
+
+        // Absent channels reserve once they get their first index
+        for (auto column : {&this->normals_indices, &this->tex_coord_indices, &this->color_indices}) {
+            if (!column->empty()) {
+                column->reserve(column->size() + indices);
             }
+        }
+    }
 
-            if (index >= data.size()) {
-                throw ValidationException();
+    void FaceTable::materialize_channel(std::vector<index_t>& column, size_t count) const {
+        column.reserve(this->vertices_indices.capacity());
+        column.assign(count, absent_index);
+    }
+
+    // Called after the vertex indices of the appended corners are pushed
+    void FaceTable::append_channel(std::vector<index_t>& column, IndexRange const& range, size_t count) {
+        if (range.empty()) {
+            if (!column.empty()) {
+                column.insert(column.end(), count, absent_index);
             }
+
+            return;
+        }
+
+        if (column.empty()) {
+            this->materialize_channel(column, this->vertices_indices.size() - count);
         }
+
+        column.insert(column.end(), range.begin(), range.end());
+    }
+
+    void FaceTable::push_face(FaceView const& face) {
+        this->vertices_indices.insert(this->vertices_indices.end(), face.vertices_indices.begin(), face.vertices_indices.end());
+        this->append_channel(this->normals_indices, face.normals_indices, face.size());
+        this->append_channel(this->tex_coord_indices, face.tex_coord_indices, face.size());
+        this->append_channel(this->color_indices, face.color_indices, face.size());
+        this->end_face();
+    }
+
+    void FaceTable::push_faces(FaceTable const& faces) {
+        const auto base = index_t(this->indices_count());
+        const auto count = faces.indices_count();
+
+        this->vertices_indices.insert(this->vertices_indices.end(), faces.vertices_indices.begin(), faces.vertices_indices.end());
+        this->append_channel(this->normals_indices, get_range(faces.normals_indices, 0, count), count);
+        this->append_channel(this->tex_coord_indices, get_range(faces.tex_coord_indices, 0, count), count);
+        this->append_channel(this->color_indices, get_range(faces.color_indices, 0, count), count);
+
+        this->offsets.reserve(this->offsets.size() + faces.size());
+
+        for (size_t i = 1; i < faces.offsets.size(); i++) {
+            this->offsets.push_back(base + faces.offsets[i]);
+        }
+    }
+
+    static void track_indices(std::vector<index_t> const& indices, size_t first_index, size_t& bound) {
+        for (size_t i = first_index; i < indices.size(); i++) {
+            if (indices[i] != ::mesh::absent_index) {
+                bound = std::max(bound, size_t(indices[i]) + 1);
+            }
+        }
+    }
+
+    // Bounds are tracked while faces are pushed, so validation doesn't need another pass over the faces,
+    // only the indices appended from first_index are scanned
+    void MeshLayoutBuilder::track_indices(size_t first_index) {
+        ::mesh::track_indices(this->faces.vertices_indices, first_index, this->bounds.vertices);
+        ::mesh::track_indices(this->faces.normals_indices, first_index, this->bounds.normals);
+        ::mesh::track_indices(this->faces.tex_coord_indices, first_index, this->bounds.tex_coords);
+        ::mesh::track_indices(this->faces.color_indices, first_index, this->bounds.colors);
     }
 
     void MeshLayoutBuilder::validate_indices() {
-        for (auto const& face : faces) {
-            ::mesh::validate_indices(face.vertices_indices, this->vertices);
-            ::mesh::validate_indices(face.normals_indices, this->normals);
-            ::mesh::validate_indices(face.tex_coord_indices, this->tex_coords);
-            ::mesh::validate_indices(face.color_indices, this->colors);
+        check_index_capacity(this->vertices.size());
+        check_index_capacity(this->normals.size());
+        check_index_capacity(this->tex_coords.size());
+        check_index_capacity(this->colors.size());
+        check_index_capacity(this->faces.indices_count());
+
+        if (this->bounds.vertices > this->vertices.size() ||
+            this->bounds.normals > this->normals.size() ||
+            this->bounds.tex_coords > this->tex_coords.size() ||
+            this->bounds.colors > this->colors.size())
+        {
+            throw ValidationException();
         }
     }
 
@@ -61,30 +135,43 @@ namespace mesh {
         this->triplets.push_back(triplet);
     }
 
-    void MeshLayoutBuilder::push_face_layout(FaceLayout const& face) {
-        this->faces.push_back(face);
+    void MeshLayoutBuilder::push_face(FaceView const& face) {
+        const auto first_index = this->faces.indices_count();
+        this->faces.push_face(face);
+        this->track_indices(first_index);
+    }
+
+    void MeshLayoutBuilder::push_faces(FaceTable const& faces) {
+        const auto first_index = this->faces.indices_count();
+        this->faces.push_faces(faces);
+        this->track_indices(first_index);
+    }
+
+    void MeshLayoutBuilder::push_faces(FaceTable&& faces) {
+        if (!this->faces.empty()) {
+            this->push_faces(faces);
+            return;
+        }
+
+        this->faces = std::move(faces);
+        this->track_indices(0);
     }
 
     void MeshLayoutBuilder::push_triplet_face() {
-        std::vector<size_t> vertices_indices;
-        std::vector<size_t> normals_indices;
-        std::vector<size_t> tex_coord_indices;
-        std::vector<size_t> color_indices;
+        const auto first_index = this->faces.indices_count();
 
         for (auto const& triplet : this->triplets) {
-            vertices_indices.push_back(triplet.vertex_index);
-            normals_indices.push_back(triplet.normal_index);
-            tex_coord_indices.push_back(triplet.tex_coord_index);
-            color_indices.push_back(::mesh::absent_index);
+            this->faces.push_index(
+                triplet.vertex_index,
+                triplet.normal_index,
+                triplet.tex_coord_index,
+                ::mesh::absent_index
+            );
         }
 
         this->triplets.clear();
-        this->faces.emplace_back(
-            vertices_indices,
-            normals_indices,
-            tex_coord_indices,
-            color_indices
-        );
+        this->faces.end_face();
+        this->track_indices(first_index);
     }
 
     void MeshLayoutBuilder::push_triplet_face(TripletFace const& face) {
@@ -102,52 +189,42 @@ namespace mesh {
         auto normal_start = this->normals.size();
         auto tex_coord_start = this->tex_coords.size();
 
-        auto const size = polygon.vertices.size();
-
-        std::vector<size_t> vertices_indices(size);
-        std::vector<size_t> normals_indices(size);
-        std::vector<size_t> tex_coord_indices(size);
-        std::vector<size_t> colors_indices(size);
-
-        std::iota(vertices_indices.begin(), vertices_indices.end(), vertex_start);
-        std::fill(colors_indices.begin(), colors_indices.end(), ::mesh::absent_index);
+        auto const size = polygon.vertices().size();
+        auto const first_index = this->faces.indices_count();
 
         std::copy(
-            std::begin(polygon.vertices),
-            std::end(polygon.vertices),
+            std::begin(polygon.vertices()),
+            std::end(polygon.vertices()),
             std::back_inserter(this->vertices)
         );
 
-        if (polygon.normals) {
+        if (polygon.normals()) {
             std::copy(
-                std::begin(polygon.normals.value()),
-                std::end(polygon.normals.value()),
+                std::begin(polygon.normals().value()),
+                std::end(polygon.normals().value()),
                 std::back_inserter(this->normals)
             );
-            std::iota(normals_indices.begin(), normals_indices.end(), normal_start);
-        }
-        else {
-            std::fill(normals_indices.begin(), normals_indices.end(), ::mesh::absent_index);
         }
 
-        if (polygon.tex_coords) {
+        if (polygon.tex_coords()) {
             std::copy(
-                std::begin(polygon.tex_coords.value()),
-                std::end(polygon.tex_coords.value()),
+                std::begin(polygon.tex_coords().value()),
+                std::end(polygon.tex_coords().value()),
                 std::back_inserter(this->tex_coords)
             );
-            std::iota(tex_coord_indices.begin(), tex_coord_indices.end(), tex_coord_start);
         }
-        else {
-            std::fill(tex_coord_indices.begin(), tex_coord_indices.end(), ::mesh::absent_index);
+
+        for (size_t i = 0; i < size; i++) {
+            this->faces.push_index(
+                index_t(vertex_start + i),
+                polygon.normals() ? index_t(normal_start + i) : ::mesh::absent_index,
+                polygon.tex_coords() ? index_t(tex_coord_start + i) : ::mesh::absent_index,
+                ::mesh::absent_index
+            );
         }
 
-        this->faces.emplace_back(
-            vertices_indices,
-            normals_indices,
-            tex_coord_indices,
-            colors_indices
-        );
+        this->faces.end_face();
+        this->track_indices(first_index);
     }
 
     void MeshLayoutBuilder::push_triangle(Triangle const& triangle) {
@@ -156,30 +233,30 @@ namespace mesh {
         std::vector<glm::vec2> polygon_tex_coords;
 
         std::copy(
-            std::begin(triangle.vertices),
-            std::end(triangle.vertices),
+            std::begin(triangle.vertices()),
+            std::end(triangle.vertices()),
             std::back_inserter(polygon_vertices)
         );
 
-        if (triangle.normals) {
+        if (triangle.normals()) {
             std::copy(
-                std::begin(triangle.normals.value()),
-                std::end(triangle.normals.value()),
+                std::begin(triangle.normals().value()),
+                std::end(triangle.normals().value()),
                 std::back_inserter(polygon_normals)
             );
         }
 
-        if (triangle.tex_coords) {
+        if (triangle.tex_coords()) {
             std::copy(
-                std::begin(triangle.tex_coords.value()),
-                std::end(triangle.tex_coords.value()),
+                std::begin(triangle.tex_coords().value()),
+                std::end(triangle.tex_coords().value()),
                 std::back_inserter(polygon_tex_coords)
             );
         }
 
         this->push_polygon(
             Polygon(
-                polygon_vertices,
+                std::move(polygon_vertices),
                 !polygon_normals.empty() ? std::make_optional(std::move(polygon_normals)) : std::nullopt,
                 !polygon_tex_coords.empty() ? std::make_optional(std::move(polygon_tex_coords)) : std::nullopt,
                 std::nullopt
@@ -193,6 +270,32 @@ namespace mesh {
         }
     }
 
+    template<typename T>
+    static void append(std::vector<T>& data, std::vector<T>&& items) {
+        if (data.empty()) {
+            data = std::move(items);
+        }
+        else {
+            data.insert(data.end(), items.begin(), items.end());
+        }
+    }
+
+    void MeshLayoutBuilder::push_vertices(std::vector<glm::vec3>&& items) {
+        append(this->vertices, std::move(items));
+    }
+
+    void MeshLayoutBuilder::push_normals(std::vector<glm::vec3>&& items) {
+        append(this->normals, std::move(items));
+    }
+
+    void MeshLayoutBuilder::push_tex_coords(std::vector<glm::vec2>&& items) {
+        append(this->tex_coords, std::move(items));
+    }
+
+    void MeshLayoutBuilder::push_colors(std::vector<glm::vec4>&& items) {
+        append(this->colors, std::move(items));
+    }
+
     void MeshLayoutBuilder::push_normals(std::vector<glm::vec3> const& items) {
         for (auto const& item : items) {
             this->push_normal(item);
@@ -234,10 +337,4 @@ namespace mesh {
             this->push_triangle(item);
         }
     }
-
-    void MeshLayoutBuilder::push_face_layouts(std::vector<FaceLayout> const& items) {
-        for (auto const& item : items) {
-            this->push_face_layout(item);
-        }
-    }
 }
@@ -0,0 +1,263 @@
+#include "mesh_cache.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace mesh_cache {
+
+    static const std::array<char, 8> magic = {'O', '2', 'S', 'M', 'E', 'S', 'H', '\0'};
+
+    // Written as the native representation of 0x01020304, a cache from a machine
+    // with another byte order is treated as a miss
+    static const uint32_t byte_order_mark = 0x01020304;
+
+    static_assert(sizeof(glm::vec2) == 2 * sizeof(float));
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+    static_assert(sizeof(glm::vec4) == 4 * sizeof(float));
+
+    constexpr uint32_t normals_channel = 1;
+    constexpr uint32_t tex_coords_channel = 2;
+    constexpr uint32_t colors_channel = 4;
+
+    // Followed by vertices, normals, tex coords, colors, faces + 1 face offsets, the vertices
+    // index column and the normals, tex coords and colors columns present in channels, indices each.
+    // Offsets and indices are mesh::index_t of index_size bytes
+    struct Header {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t byte_order_mark;
+        uint32_t index_size;
+        uint32_t channels;
+        SourceKey key;
+        uint64_t vertices;
+        uint64_t normals;
+        uint64_t tex_coords;
+        uint64_t colors;
+        uint64_t faces;
+        uint64_t indices;
+    };
+
+    static uint64_t get_columns_count(uint32_t channels) {
+        return 1 +
+            ((channels & normals_channel) != 0 ? 1 : 0) +
+            ((channels & tex_coords_channel) != 0 ? 1 : 0) +
+            ((channels & colors_channel) != 0 ? 1 : 0);
+    }
+
+    static uint32_t get_channels(mesh::FaceTable const& faces) {
+        return (faces.has_normals() ? normals_channel : 0) |
+            (faces.has_tex_coords() ? tex_coords_channel : 0) |
+            (faces.has_colors() ? colors_channel : 0);
+    }
+
+    // Takes count items of item_size bytes off the remaining bytes. Counts come from disk, they are checked
+    // against the remaining bytes before they are multiplied, so a corrupted header can't wrap the size around
+    static void consume_items(uint64_t& remaining, uint64_t count, uint64_t item_size) {
+        if (count > remaining / item_size) {
+            throw CacheException();
+        }
+
+        remaining -= count * item_size;
+    }
+
+    static void check_data_size(Header const& header, uint64_t data_size) {
+        uint64_t remaining = data_size;
+
+        // Also keeps faces + 1 from wrapping around
+        if (header.faces >= remaining) {
+            throw CacheException();
+        }
+
+        consume_items(remaining, header.vertices, sizeof(glm::vec3));
+        consume_items(remaining, header.normals, sizeof(glm::vec3));
+        consume_items(remaining, header.tex_coords, sizeof(glm::vec2));
+        consume_items(remaining, header.colors, sizeof(glm::vec4));
+        consume_items(remaining, header.faces + 1, sizeof(mesh::index_t));
+
+        for (uint64_t column = 0; column < get_columns_count(header.channels); column++) {
+            consume_items(remaining, header.indices, sizeof(mesh::index_t));
+        }
+
+        if (remaining != 0) {
+            throw CacheException();
+        }
+    }
+
+    SourceKey get_source_key(std::string const& source_path) {
+        std::error_code error;
+        const auto size = fs::file_size(source_path, error);
+
+        if (error) {
+            throw std::ifstream::failure("can't stat file '" + source_path + "'");
+        }
+
+        const auto mtime = fs::last_write_time(source_path, error);
+
+        if (error) {
+            throw std::ifstream::failure("can't stat file '" + source_path + "'");
+        }
+
+        return SourceKey { size, int64_t(mtime.time_since_epoch().count()) };
+    }
+
+    std::string get_cache_path(std::string const& source_path) {
+        return source_path + ".meshcache";
+    }
+
+    template<typename T>
+    static void write_array(std::ofstream& stream, std::vector<T> const& items) {
+        stream.write(reinterpret_cast<const char*>(items.data()), std::streamsize(items.size() * sizeof(T)));
+    }
+
+    void write_to_file(std::string const& cache_path, SourceKey const& key, mesh::MeshLayout const& layout) {
+        Header header {};
+        header.magic = magic;
+        header.version = version;
+        header.byte_order_mark = byte_order_mark;
+        header.index_size = sizeof(mesh::index_t);
+        header.channels = get_channels(layout.faces());
+        header.key = key;
+        header.vertices = layout.vertices().size();
+        header.normals = layout.normals().size();
+        header.tex_coords = layout.tex_coords().size();
+        header.colors = layout.colors().size();
+        header.faces = layout.faces().size();
+        header.indices = layout.faces().indices_count();
+
+        std::ofstream stream;
+        stream.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        stream.open(cache_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+        write_array(stream, layout.vertices());
+        write_array(stream, layout.normals());
+        write_array(stream, layout.tex_coords());
+        write_array(stream, layout.colors());
+        write_array(stream, layout.faces().offsets);
+        write_array(stream, layout.faces().vertices_indices);
+
+        // Absent channels are empty and take no space
+        write_array(stream, layout.faces().normals_indices);
+        write_array(stream, layout.faces().tex_coord_indices);
+        write_array(stream, layout.faces().color_indices);
+    }
+
+    // The layout owns its arrays as vectors, so they are copied out of the mapping. Arrays are written
+    // back to back without padding, memcpy also reads 64 bit indices that aren't 8 byte aligned
+    template<typename T>
+    static std::vector<T> read_array(const char*& data, uint64_t count) {
+        std::vector<T> items(count);
+
+        if (count > 0) {
+            std::memcpy(items.data(), data, count * sizeof(T));
+        }
+
+        data += count * sizeof(T);
+        return items;
+    }
+
+    static std::vector<mesh::index_t> read_channel(const char*& data, Header const& header, uint32_t channel) {
+        if ((header.channels & channel) == 0) {
+            return {};
+        }
+
+        return read_array<mesh::index_t>(data, header.indices);
+    }
+
+    std::shared_ptr<mesh::MeshLayout> read_from_file(std::string const& cache_path, SourceKey const& key) {
+        std::error_code error;
+
+        if (!fs::is_regular_file(cache_path, error)) {
+            return nullptr;
+        }
+
+        const utils::MappedFile file(cache_path);
+        const auto view = file.view();
+
+        Header header {};
+
+        if (view.size() < sizeof(Header)) {
+            throw CacheException();
+        }
+
+        std::memcpy(&header, view.data(), sizeof(Header));
+
+        if (header.magic != magic) {
+            throw CacheException();
+        }
+
+        if (header.version != version ||
+            header.byte_order_mark != byte_order_mark ||
+            header.index_size != sizeof(mesh::index_t) ||
+            !(header.key == key))
+        {
+            return nullptr;
+        }
+
+        check_data_size(header, view.size() - sizeof(Header));
+
+        const char* data = view.data() + sizeof(Header);
+
+        mesh::MeshLayoutBuilder builder;
+        builder.push_vertices(read_array<glm::vec3>(data, header.vertices));
+        builder.push_normals(read_array<glm::vec3>(data, header.normals));
+        builder.push_tex_coords(read_array<glm::vec2>(data, header.tex_coords));
+        builder.push_colors(read_array<glm::vec4>(data, header.colors));
+
+        mesh::FaceTable faces;
+        faces.offsets = read_array<mesh::index_t>(data, header.faces + 1);
+        faces.vertices_indices = read_array<mesh::index_t>(data, header.indices);
+        faces.normals_indices = read_channel(data, header, normals_channel);
+        faces.tex_coord_indices = read_channel(data, header, tex_coords_channel);
+        faces.color_indices = read_channel(data, header, colors_channel);
+
+        if (faces.offsets.front() != 0 || faces.offsets.back() != header.indices) {
+            throw CacheException();
+        }
+
+        if (!std::is_sorted(faces.offsets.begin(), faces.offsets.end())) {
+            throw CacheException();
+        }
+
+        builder.push_faces(std::move(faces));
+
+        try {
+            return builder.build();
+        }
+        catch (mesh::ValidationException const& e) {
+            throw CacheException();
+        }
+    }
+
+    std::shared_ptr<mesh::MeshLayout> load(std::string const& source_path, SourceKey const& key) {
+        try {
+            return read_from_file(get_cache_path(source_path), key);
+        }
+        // Whatever went wrong with the cache, the source is parsed instead
+        catch (std::exception const& e) {
+            return nullptr;
+        }
+    }
+
+    void save(std::string const& source_path, SourceKey const& key, mesh::MeshLayout const& layout) {
+        const auto cache_path = get_cache_path(source_path);
+        const auto tmp_path = cache_path + ".tmp";
+
+        try {
+            write_to_file(tmp_path, key, layout);
+        }
+        catch (...) {
+            std::remove(tmp_path.c_str());
+            throw;
+        }
+
+        fs::rename(tmp_path, cache_path);
+    }
+
+}
@@ -1,27 +1,40 @@
 #include "mesh.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <numeric>
 
 namespace mesh {
+    // Absent channels have no indices at all, presence is checked once per table rather than per corner
+    static index_t get_channel_index(IndexRange const& range, bool has_channel, size_t index) {
+        return has_channel ? range[index] : ::mesh::absent_index;
+    }
+
     std::vector<glm::vec3> const& MeshLayoutReader::vertices() {
-        return this->layout->vertices;
+        return this->layout->vertices();
     }
 
     std::vector<glm::vec3> const& MeshLayoutReader::normals() {
-        return this->layout->normals;
+        return this->layout->normals();
     }
 
     std::vector<glm::vec2> const& MeshLayoutReader::tex_coords() {
-        return this->layout->tex_coords;
+        return this->layout->tex_coords();
     }
 
     std::vector<Triplet> const& MeshLayoutReader::triplets() {
         this->triplets_data.clear();
+        this->triplets_data.reserve(this->layout->faces().indices_count());
+
+        const auto has_normals = this->layout->faces().has_normals();
+        const auto has_tex_coords = this->layout->faces().has_tex_coords();
 
-        for (auto const& face : this->layout->faces) {
-            for (int i = 0; i < face.vertices_indices.size(); i++) {
+        for (const auto face : this->layout->faces()) {
+            for (size_t i = 0; i < face.size(); i++) {
                 this->triplets_data.emplace_back(
                     face.vertices_indices[i],
-                    face.normals_indices[i],
-                    face.tex_coord_indices[i]
+                    get_channel_index(face.normals_indices, has_normals, i),
+                    get_channel_index(face.tex_coord_indices, has_tex_coords, i)
                 );
             }
         }
@@ -31,16 +44,20 @@ namespace mesh {
 
     std::vector<TripletFace> const& MeshLayoutReader::triplet_faces() {
         this->triplet_faces_data.clear();
+        this->triplet_faces_data.reserve(this->layout->faces().size());
 
-        for (auto const& face : this->layout->faces) {
+        const auto has_normals = this->layout->faces().has_normals();
+        const auto has_tex_coords = this->layout->faces().has_tex_coords();
+
+        for (const auto face : this->layout->faces()) {
             std::vector<Triplet> triplets;
-            triplets.reserve(face.vertices_indices.size());
+            triplets.reserve(face.size());
 
-            for (int i = 0; i < face.vertices_indices.size(); i++) {
+            for (size_t i = 0; i < face.size(); i++) {
                 triplets.emplace_back(
                     face.vertices_indices[i],
-                    face.normals_indices[i],
-                    face.tex_coord_indices[i]
+                    get_channel_index(face.normals_indices, has_normals, i),
+                    get_channel_index(face.tex_coord_indices, has_tex_coords, i)
                 );
             }
 
@@ -52,52 +69,310 @@ namespace mesh {
 
     std::vector<Triangle> const& MeshLayoutReader::triangles() {
         this->triangles_data.clear();
+        this->triangles_data.reserve(this->triangles_count());
 
-        for (auto polygon : this->polygons()) {
-            auto triangles = this->triangulation_strategy->triangulate(polygon);
-
-            std::copy(
-                triangles.begin(),
-                triangles.end(),
-                std::back_inserter(this->triangles_data)
-            );
-        }
+        this->for_each_triangle([this](Triangle const& triangle) {
+            this->triangles_data.push_back(triangle);
+        });
 
         return this->triangles_data;
     }
 
     std::vector<Polygon> const& MeshLayoutReader::polygons() {
         this->polygons_data.clear();
+        this->polygons_data.reserve(this->layout->faces().size());
 
-        for (auto const& face : this->layout->faces) {
-            std::vector<glm::vec3> vertices;
-            std::vector<glm::vec3> normals;
-            std::vector<glm::vec2> tex_coords;
+        for (const auto face : this->layout->faces()) {
+            this->polygons_data.push_back(this->get_polygon(face));
+        }
 
-            for (int i = 0; i < face.vertices_indices.size(); i++) {
-                assert(face.vertices_indices[i] != ::mesh::absent_index);
+        return this->polygons_data;
+    }
 
-                vertices.push_back(this->layout->vertices[face.vertices_indices[i]]);
+    Polygon MeshLayoutReader::get_polygon(FaceView const& face) const {
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> tex_coords;
 
-                if (face.normals_indices[i] != ::mesh::absent_index) {
-                    normals.push_back(this->layout->normals[face.normals_indices[i]]);
-                }
+        vertices.reserve(face.size());
 
-                if (face.tex_coord_indices[i] != ::mesh::absent_index) {
-                    tex_coords.push_back(this->layout->tex_coords[face.tex_coord_indices[i]]);
-                }
+        for (const auto index : face.vertices_indices) {
+            assert(index != ::mesh::absent_index);
+            vertices.push_back(this->layout->vertices()[index]);
+        }
+
+        // Ranges of absent channels are empty, so these loops only run for stored channels
+        for (const auto index : face.normals_indices) {
+            if (index != ::mesh::absent_index) {
+                normals.push_back(this->layout->normals()[index]);
             }
+        }
 
-            this->polygons_data.push_back(
-                Polygon(
-                    vertices,
-                    vertices.size() == normals.size() ? std::make_optional(std::move(normals)) : std::nullopt,
-                    vertices.size() == tex_coords.size() ? std::make_optional(std::move(tex_coords)) : std::nullopt,
-                    {}
-                )
-            );
+        for (const auto index : face.tex_coord_indices) {
+            if (index != ::mesh::absent_index) {
+                tex_coords.push_back(this->layout->tex_coords()[index]);
+            }
         }
 
-        return this->polygons_data;
+        // Decided before the vertices are moved out, argument evaluation order is unspecified
+        const auto has_normals = vertices.size() == normals.size();
+        const auto has_tex_coords = vertices.size() == tex_coords.size();
+
+        return Polygon(
+            std::move(vertices),
+            has_normals ? std::make_optional(std::move(normals)) : std::nullopt,
+            has_tex_coords ? std::make_optional(std::move(tex_coords)) : std::nullopt,
+            std::nullopt
+        );
+    }
+
+    static bool has_all_indices(IndexRange const& range) {
+        return !range.empty() && std::find(range.begin(), range.end(), ::mesh::absent_index) == range.end();
+    }
+
+    TriangleRange::const_iterator::const_iterator(MeshLayout const* layout, size_t face, size_t last_face) :
+        layout(layout),
+        face(face),
+        last_face(last_face)
+    {
+        this->seek_face();
+    }
+
+    void TriangleRange::const_iterator::seek_face() {
+        auto const& faces = this->layout->faces();
+
+        while (this->face < this->last_face && faces.offsets[this->face + 1] - faces.offsets[this->face] < 3) {
+            this->face += 1;
+        }
+
+        this->corner = 1;
+
+        if (this->face < this->last_face) {
+            const auto face = faces[this->face];
+            this->has_normals = has_all_indices(face.normals_indices);
+            this->has_tex_coords = has_all_indices(face.tex_coord_indices);
+        }
+    }
+
+    static Triangle get_triangle(
+        MeshLayout const& layout,
+        std::array<size_t, 3> const& corners,
+        bool has_normals,
+        bool has_tex_coords
+    ) {
+        auto const& faces = layout.faces();
+
+        std::array<glm::vec3, 3> vertices;
+        std::optional<std::array<glm::vec3, 3>> normals;
+        std::optional<std::array<glm::vec2, 3>> tex_coords;
+
+        for (size_t i = 0; i < 3; i++) {
+            vertices[i] = layout.vertices()[faces.vertices_indices[corners[i]]];
+        }
+
+        if (has_normals) {
+            normals.emplace();
+
+            for (size_t i = 0; i < 3; i++) {
+                (*normals)[i] = layout.normals()[faces.normals_indices[corners[i]]];
+            }
+        }
+
+        if (has_tex_coords) {
+            tex_coords.emplace();
+
+            for (size_t i = 0; i < 3; i++) {
+                (*tex_coords)[i] = layout.tex_coords()[faces.tex_coord_indices[corners[i]]];
+            }
+        }
+
+        return Triangle(vertices, normals, tex_coords, std::nullopt);
+    }
+
+    Triangle TriangleRange::const_iterator::operator*() const {
+        const size_t first = this->layout->faces().offsets[this->face];
+
+        return get_triangle(
+            *this->layout,
+            {first, first + this->corner, first + this->corner + 1},
+            this->has_normals,
+            this->has_tex_coords
+        );
+    }
+
+    TriangleRange::const_iterator& TriangleRange::const_iterator::operator++() {
+        auto const& faces = this->layout->faces();
+        const size_t face_size = faces.offsets[this->face + 1] - faces.offsets[this->face];
+
+        this->corner += 1;
+
+        if (this->corner + 1 >= face_size) {
+            this->face += 1;
+            this->seek_face();
+        }
+
+        return *this;
+    }
+
+    size_t TriangleRange::size() const {
+        auto const& offsets = this->layout->faces().offsets;
+        size_t count = 0;
+
+        for (size_t i = this->first_face; i < this->last_face; i++) {
+            const size_t face_size = offsets[i + 1] - offsets[i];
+            count += face_size >= 3 ? face_size - 2 : 0;
+        }
+
+        return count;
+    }
+
+    Triangle TriangleIndexBuffer::get_triangle(MeshLayout const& layout, size_t index) const {
+        const auto channels = this->channels[index];
+
+        return ::mesh::get_triangle(
+            layout,
+            {this->corners[3 * index], this->corners[3 * index + 1], this->corners[3 * index + 2]},
+            (channels & normals_channel) != 0,
+            (channels & tex_coords_channel) != 0
+        );
+    }
+
+    // Fewer faces per thread aren't worth starting the thread for
+    static constexpr size_t min_faces_per_thread = 4096;
+
+    static uint8_t get_face_channels(FaceView const& face) {
+        return (has_all_indices(face.normals_indices) ? TriangleIndexBuffer::normals_channel : 0) |
+            (has_all_indices(face.tex_coord_indices) ? TriangleIndexBuffer::tex_coords_channel : 0);
+    }
+
+    static void triangulate_faces(MeshLayout const& layout, TriangulationStrategy& strategy, TriangleIndexBuffer& triangulation) {
+        for (size_t i = 0; i < layout.faces().size(); i++) {
+            const auto channels = get_face_channels(layout.faces()[i]);
+
+            strategy.triangulate_face(layout, i, triangulation.corners);
+            triangulation.channels.resize(triangulation.corners.size() / 3, channels);
+        }
+    }
+
+    // Faces are split in contiguous chunks, one per thread. The n - 2 triangles counts of the chunks are summed
+    // concurrently and scanned into chunk offsets in the preallocated buffer, then every thread triangulates its
+    // chunk in place with its own clone of the strategy. Returns false when the strategy can't be cloned
+    static bool triangulate_faces(
+        MeshLayout const& layout,
+        TriangulationStrategy& strategy,
+        size_t chunks_count,
+        TriangleIndexBuffer& triangulation
+    ) {
+        auto const& faces = layout.faces();
+        std::vector<std::unique_ptr<TriangulationStrategy>> strategies(chunks_count);
+
+        for (auto& chunk_strategy : strategies) {
+            chunk_strategy = strategy.clone();
+
+            if (!chunk_strategy) {
+                return false;
+            }
+        }
+
+        const auto get_first_face = [&faces, chunks_count](size_t chunk) {
+            return faces.size() * chunk / chunks_count;
+        };
+
+        // Triangles before every chunk, after the scan
+        std::vector<size_t> offsets(chunks_count + 1, 0);
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            size_t count = 0;
+
+            for (auto face = get_first_face(chunk); face < get_first_face(chunk + 1); face++) {
+                const size_t face_size = faces.offsets[face + 1] - faces.offsets[face];
+                count += face_size >= 3 ? face_size - 2 : 0;
+            }
+
+            offsets[chunk + 1] = count;
+        });
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        triangulation.corners.resize(3 * offsets.back());
+        triangulation.channels.resize(offsets.back());
+
+        // A strategy may write less than n - 2 triangles for a degenerate face, which leaves a gap at the chunk end
+        std::vector<size_t> counts(chunks_count, 0);
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            auto position = offsets[chunk];
+
+            for (auto face = get_first_face(chunk); face < get_first_face(chunk + 1); face++) {
+                const auto count = strategies[chunk]->triangulate_face_into(
+                    layout,
+                    face,
+                    triangulation.corners.data() + 3 * position
+                );
+
+                std::fill_n(triangulation.channels.begin() + position, count, get_face_channels(faces[face]));
+                position += count;
+            }
+
+            counts[chunk] = position - offsets[chunk];
+        });
+
+        size_t position = 0;
+
+        for (size_t chunk = 0; chunk < chunks_count; chunk++) {
+            if (position != offsets[chunk]) {
+                const auto first = offsets[chunk];
+                const auto last = first + counts[chunk];
+
+                auto& corners = triangulation.corners;
+                auto& channels = triangulation.channels;
+
+                std::copy(corners.begin() + 3 * first, corners.begin() + 3 * last, corners.begin() + 3 * position);
+                std::copy(channels.begin() + first, channels.begin() + last, channels.begin() + position);
+            }
+
+            position += counts[chunk];
+        }
+
+        triangulation.corners.resize(3 * position);
+        triangulation.channels.resize(position);
+
+        return true;
+    }
+
+    std::shared_ptr<const TriangleIndexBuffer> MeshLayout::triangulation(TriangulationStrategy& strategy, size_t threads) const {
+        auto& cache = *this->triangulation_cache;
+        const std::lock_guard<std::mutex> lock(cache.mutex);
+        const std::type_index strategy_type = typeid(strategy);
+        const bool uses_positions = strategy.uses_positions();
+
+        if (
+            cache.data &&
+            cache.strategy == strategy_type &&
+            cache.faces.lock() == this->faces_data &&
+            (!uses_positions || cache.vertices.lock() == this->vertices_data)
+        ) {
+            return cache.data;
+        }
+
+        auto triangulation = std::make_shared<TriangleIndexBuffer>();
+        const auto chunks_count = std::min(threads, this->faces().size() / min_faces_per_thread);
+
+        if (chunks_count < 2 || !triangulate_faces(*this, strategy, chunks_count, *triangulation)) {
+            // Exact for every valid triangulation: n - 2 triangles per face of n corners
+            const auto triangles_count = TriangleRange(*this).size();
+
+            triangulation->corners.reserve(3 * triangles_count);
+            triangulation->channels.reserve(triangles_count);
+
+            triangulate_faces(*this, strategy, *triangulation);
+        }
+
+        cache.data = std::move(triangulation);
+        cache.strategy = strategy_type;
+        cache.faces = this->faces_data;
+        cache.vertices = uses_positions ? this->vertices_data : nullptr;
+
+        return cache.data;
     }
 }
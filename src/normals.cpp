@@ -0,0 +1,153 @@
+#include "normals.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NORMALS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace normals {
+
+    static void calculate_normals_scalar(TriangleBlock const& triangles, NormalBlock& normals) {
+        auto const& c = triangles.corners;
+
+        for (size_t i = 0; i < block_size; i++) {
+            const float e1x = c[3][i] - c[0][i];
+            const float e1y = c[4][i] - c[1][i];
+            const float e1z = c[5][i] - c[2][i];
+            const float e2x = c[6][i] - c[0][i];
+            const float e2y = c[7][i] - c[1][i];
+            const float e2z = c[8][i] - c[2][i];
+
+            const float x = e1y * e2z - e2y * e1z;
+            const float y = e1z * e2x - e2z * e1x;
+            const float z = e1x * e2y - e2x * e1y;
+
+            const float inverse_length = 1.0f / std::sqrt(x * x + y * y + z * z);
+
+            normals.axes[0][i] = x * inverse_length;
+            normals.axes[1][i] = y * inverse_length;
+            normals.axes[2][i] = z * inverse_length;
+        }
+    }
+
+#ifdef NORMALS_X86
+    __attribute__((target("avx2")))
+    static void calculate_normals_avx2(TriangleBlock const& triangles, NormalBlock& normals) {
+        auto const& c = triangles.corners;
+
+        for (size_t i = 0; i < block_size; i += 8) {
+            const auto x0 = _mm256_loadu_ps(c[0].data() + i);
+            const auto y0 = _mm256_loadu_ps(c[1].data() + i);
+            const auto z0 = _mm256_loadu_ps(c[2].data() + i);
+
+            const auto e1x = _mm256_sub_ps(_mm256_loadu_ps(c[3].data() + i), x0);
+            const auto e1y = _mm256_sub_ps(_mm256_loadu_ps(c[4].data() + i), y0);
+            const auto e1z = _mm256_sub_ps(_mm256_loadu_ps(c[5].data() + i), z0);
+            const auto e2x = _mm256_sub_ps(_mm256_loadu_ps(c[6].data() + i), x0);
+            const auto e2y = _mm256_sub_ps(_mm256_loadu_ps(c[7].data() + i), y0);
+            const auto e2z = _mm256_sub_ps(_mm256_loadu_ps(c[8].data() + i), z0);
+
+            const auto x = _mm256_sub_ps(_mm256_mul_ps(e1y, e2z), _mm256_mul_ps(e2y, e1z));
+            const auto y = _mm256_sub_ps(_mm256_mul_ps(e1z, e2x), _mm256_mul_ps(e2z, e1x));
+            const auto z = _mm256_sub_ps(_mm256_mul_ps(e1x, e2y), _mm256_mul_ps(e2x, e1y));
+
+            const auto squared_length = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+                _mm256_mul_ps(z, z)
+            );
+            const auto inverse_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(squared_length));
+
+            _mm256_storeu_ps(normals.axes[0].data() + i, _mm256_mul_ps(x, inverse_length));
+            _mm256_storeu_ps(normals.axes[1].data() + i, _mm256_mul_ps(y, inverse_length));
+            _mm256_storeu_ps(normals.axes[2].data() + i, _mm256_mul_ps(z, inverse_length));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static void calculate_normals_avx512(TriangleBlock const& triangles, NormalBlock& normals) {
+        static_assert(block_size == 16);
+
+        auto const& c = triangles.corners;
+
+        const auto x0 = _mm512_loadu_ps(c[0].data());
+        const auto y0 = _mm512_loadu_ps(c[1].data());
+        const auto z0 = _mm512_loadu_ps(c[2].data());
+
+        const auto e1x = _mm512_sub_ps(_mm512_loadu_ps(c[3].data()), x0);
+        const auto e1y = _mm512_sub_ps(_mm512_loadu_ps(c[4].data()), y0);
+        const auto e1z = _mm512_sub_ps(_mm512_loadu_ps(c[5].data()), z0);
+        const auto e2x = _mm512_sub_ps(_mm512_loadu_ps(c[6].data()), x0);
+        const auto e2y = _mm512_sub_ps(_mm512_loadu_ps(c[7].data()), y0);
+        const auto e2z = _mm512_sub_ps(_mm512_loadu_ps(c[8].data()), z0);
+
+        const auto x = _mm512_sub_ps(_mm512_mul_ps(e1y, e2z), _mm512_mul_ps(e2y, e1z));
+        const auto y = _mm512_sub_ps(_mm512_mul_ps(e1z, e2x), _mm512_mul_ps(e2z, e1x));
+        const auto z = _mm512_sub_ps(_mm512_mul_ps(e1x, e2y), _mm512_mul_ps(e2x, e1y));
+
+        const auto squared_length = _mm512_add_ps(
+            _mm512_add_ps(_mm512_mul_ps(x, x), _mm512_mul_ps(y, y)),
+            _mm512_mul_ps(z, z)
+        );
+        const auto inverse_length = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(squared_length));
+
+        _mm512_storeu_ps(normals.axes[0].data(), _mm512_mul_ps(x, inverse_length));
+        _mm512_storeu_ps(normals.axes[1].data(), _mm512_mul_ps(y, inverse_length));
+        _mm512_storeu_ps(normals.axes[2].data(), _mm512_mul_ps(z, inverse_length));
+    }
+#endif
+
+    bool is_supported(Isa isa) {
+        switch (isa) {
+            case Isa::Scalar:
+                return true;
+
+#ifdef NORMALS_X86
+            case Isa::Avx2:
+                return __builtin_cpu_supports("avx2");
+
+            case Isa::Avx512:
+                return __builtin_cpu_supports("avx512f");
+#endif
+
+            default:
+                return false;
+        }
+    }
+
+    Isa best_isa() {
+        static const Isa isa = [] {
+            if (is_supported(Isa::Avx512)) {
+                return Isa::Avx512;
+            }
+
+            if (is_supported(Isa::Avx2)) {
+                return Isa::Avx2;
+            }
+
+            return Isa::Scalar;
+        }();
+
+        return isa;
+    }
+
+    void calculate_normals(TriangleBlock const& triangles, NormalBlock& normals, Isa isa) {
+        switch (isa) {
+#ifdef NORMALS_X86
+            case Isa::Avx512:
+                calculate_normals_avx512(triangles, normals);
+                return;
+
+            case Isa::Avx2:
+                calculate_normals_avx2(triangles, normals);
+                return;
+#endif
+
+            default:
+                calculate_normals_scalar(triangles, normals);
+                return;
+        }
+    }
+
+}
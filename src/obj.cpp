@@ -1,152 +1,700 @@
 #include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <limits>
 #include <string>
 
 #include "obj.hpp"
+#include "scan.hpp"
 #include "utils.hpp"
 
 namespace obj_file {
 
-    static glm::vec3 parse_vec3(std::string const& line);
+    struct ElementCounts {
+        size_t v;
+        size_t vt;
+        size_t vn;
+    };
+
+    enum class Component {
+        V,
+        VT,
+        VN,
+    };
+
+    // Relative (negative) index, it can only be resolved once the number of
+    // elements parsed by the preceding chunks is known
+    struct RelativeIndex {
+        size_t triplet;
+        Component component;
+        size_t count;
+    };
+
+    static size_t resolve_relative_index(size_t value, size_t count);
+
+    // Elements parsed from a continuous range of lines, faces are kept flat
+    // until the chunks are merged
+    struct Chunk {
+        std::vector<glm::vec3> v;
+        std::vector<glm::vec2> vt;
+        std::vector<glm::vec3> vn;
+        std::vector<Triplet> triplets;
+        std::vector<size_t> face_sizes;
+        std::vector<RelativeIndex> relative_indices;
+
+        void push_vertex(glm::vec3 const& vertex) {
+            this->v.push_back(vertex);
+        }
+
+        void push_tex_coord(glm::vec2 const& tex_coord) {
+            this->vt.push_back(tex_coord);
+        }
 
-    static glm::vec2 parse_vec2(std::string const& line);
+        void push_normal(glm::vec3 const& normal) {
+            this->vn.push_back(normal);
+        }
 
-    static Face parse_face(std::string const& line);
+        void push_triplet(Triplet const& triplet) {
+            this->triplets.push_back(triplet);
+        }
 
-    static Triplet parse_triplet(std::string const& line);
+        void push_face(size_t size) {
+            this->face_sizes.push_back(size);
+        }
 
-    static size_t parse_optional_index(std::string const& str);
+        // Indices of the triplet being parsed, which is not pushed yet
+        size_t relative_index(size_t value, Component component) {
+            this->relative_indices.push_back({this->triplets.size(), component, this->count_of(component)});
+            return value;
+        }
+
+        [[nodiscard]] size_t count_of(Component component) const {
+            switch (component) {
+                case Component::V:
+                    return this->v.size();
+
+                case Component::VT:
+                    return this->vt.size();
+
+                case Component::VN:
+                    return this->vn.size();
+            }
+
+            return 0;
+        }
+    };
+
+    // Forwards elements to a handler in file order, relative indices are resolved on the fly
+    class HandlerSink {
+    public:
+        explicit HandlerSink(ObjHandler& handler) : handler(handler) {}
+
+        void push_vertex(glm::vec3 const& vertex) {
+            this->counts.v++;
+            this->handler.on_vertex(vertex);
+        }
+
+        void push_tex_coord(glm::vec2 const& tex_coord) {
+            this->counts.vt++;
+            this->handler.on_tex_coord(tex_coord);
+        }
+
+        void push_normal(glm::vec3 const& normal) {
+            this->counts.vn++;
+            this->handler.on_normal(normal);
+        }
+
+        void push_triplet(Triplet const& triplet) {
+            this->triplets.push_back(triplet);
+        }
+
+        void push_face(size_t /* size */) {
+            this->handler.on_face(this->triplets);
+            this->triplets.clear();
+        }
+
+        size_t relative_index(size_t value, Component component) {
+            switch (component) {
+                case Component::V:
+                    return resolve_relative_index(value, this->counts.v);
+
+                case Component::VT:
+                    return resolve_relative_index(value, this->counts.vt);
+
+                case Component::VN:
+                    return resolve_relative_index(value, this->counts.vn);
+            }
+
+            return value;
+        }
+
+    private:
+        ObjHandler& handler;
+        ElementCounts counts {0, 0, 0};
+        std::vector<Triplet> triplets;
+    };
+
+    static bool is_digit(char ch) {
+        return ch >= '0' && ch <= '9';
+    }
+
+    // Space separated token, slash offsets are relative to the token start
+    struct Token {
+        std::string_view text;
+        std::array<size_t, 2> slashes;
+        size_t slashes_count;
+    };
+
+    // Splits a line into tokens using the delimiter offsets found by the scanner,
+    // so token boundaries are never searched for byte by byte
+    class LineTokens {
+    public:
+        LineTokens(std::string_view line, std::vector<uint32_t> const& delimiters) :
+            line(line),
+            delimiter(delimiters.begin()),
+            delimiters_end(delimiters.end())
+        {
+            // Nothing
+        }
+
+        // Empty text when there are no more tokens
+        Token next() {
+            Token token {{}, {0, 0}, 0};
+
+            while (this->position < this->line.size()) {
+                auto end = this->line.size();
+                token.slashes_count = 0;
+
+                while (this->delimiter != this->delimiters_end) {
+                    const size_t offset = *this->delimiter++;
+
+                    if (this->line[offset] != '/') {
+                        end = offset;
+                        break;
+                    }
+
+                    if (token.slashes_count < token.slashes.size()) {
+                        token.slashes[token.slashes_count] = offset - this->position;
+                    }
+
+                    token.slashes_count++;
+                }
+
+                token.text = this->line.substr(this->position, end - this->position);
+                this->position = end + 1;
+
+                if (!token.text.empty()) {
+                    return token;
+                }
+            }
+
+            return {{}, {0, 0}, 0};
+        }
+
+    private:
+        std::string_view line;
+        std::vector<uint32_t>::const_iterator delimiter;
+        std::vector<uint32_t>::const_iterator delimiters_end;
+        size_t position = 0;
+    };
+
+    static glm::vec3 parse_vec3(LineTokens& tokens);
+
+    static glm::vec2 parse_vec2(LineTokens& tokens);
+
+    template<typename Sink>
+    static void parse_face(LineTokens& tokens, Sink& sink);
+
+    template<typename Sink>
+    static Triplet parse_triplet(Token const& token, Sink& sink);
+
+    static float parse_float(Token const& token);
+
+    template<typename Sink>
+    static size_t parse_index(std::string_view str, Component component, Sink& sink);
+
+    template<typename Sink>
+    static void parse_line(std::string_view line, std::vector<uint32_t> const& delimiters, Sink& sink) {
+        LineTokens tokens(line, delimiters);
+        const auto keyword = tokens.next().text;
+
+        if (keyword == "v") {
+            sink.push_vertex(parse_vec3(tokens));
+        }
+        else if (keyword == "vt") {
+            sink.push_tex_coord(parse_vec2(tokens));
+        }
+        else if (keyword == "vn") {
+            sink.push_normal(parse_vec3(tokens));
+        }
+        else if (keyword == "f") {
+            parse_face(tokens, sink);
+        }
+    }
+
+    template<typename Sink>
+    static void parse_lines(std::string_view data, Sink& sink) {
+        scan::LineScanner scanner(data);
+        std::string_view line;
+        std::vector<uint32_t> delimiters;
+
+        while (scanner.next_line(line, delimiters)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+
+            parse_line(line, delimiters, sink);
+        }
+    }
+
+    // Split data into at most `count` parts of similar size, each part ends at a line boundary
+    static std::vector<std::string_view> split_into_chunks(std::string_view data, size_t count) {
+        static constexpr size_t min_chunk_size = 64 * 1024;
+
+        count = std::max<size_t>(1, std::min(count, data.size() / min_chunk_size));
+
+        const auto chunk_size = data.size() / count;
+        std::vector<std::string_view> chunks;
+
+        while (chunks.size() + 1 < count && data.size() > chunk_size) {
+            const auto line_end = data.find('\n', chunk_size);
+
+            if (line_end == std::string_view::npos) {
+                break;
+            }
+
+            chunks.push_back(data.substr(0, line_end + 1));
+            data.remove_prefix(line_end + 1);
+        }
+
+        chunks.push_back(data);
+        return chunks;
+    }
+
+    static size_t resolve_relative_index(size_t value, size_t count) {
+        if (value > count) {
+            throw ParseException();
+        }
+
+        return count - value + 1;
+    }
+
+    static void resolve_relative_indices(Chunk& chunk, ElementCounts base) {
+        for (auto const& index : chunk.relative_indices) {
+            auto& triplet = chunk.triplets[index.triplet];
+
+            switch (index.component) {
+                case Component::V:
+                    triplet.v = resolve_relative_index(triplet.v, base.v + index.count);
+                    break;
+
+                case Component::VT:
+                    triplet.vt = resolve_relative_index(triplet.vt, base.vt + index.count);
+                    break;
+
+                case Component::VN:
+                    triplet.vn = resolve_relative_index(triplet.vn, base.vn + index.count);
+                    break;
+            }
+        }
+    }
+
+    // Element counts of the preceding chunks (prefix sum) give every chunk
+    // its global offset, which is all that relative indices need
+    static ElementCounts resolve_chunks(std::vector<Chunk>& chunks, size_t& faces_count) {
+        ElementCounts total {0, 0, 0};
+        faces_count = 0;
+
+        for (auto& chunk : chunks) {
+            resolve_relative_indices(chunk, total);
+
+            total.v += chunk.v.size();
+            total.vt += chunk.vt.size();
+            total.vn += chunk.vn.size();
+            faces_count += chunk.face_sizes.size();
+        }
+
+        if (total.v == 0) {
+            throw StructIsException();
+        }
+
+        return total;
+    }
+
+    static ObjStruct merge_chunks(std::vector<Chunk>& chunks) {
+        size_t faces_count;
+        const auto total = resolve_chunks(chunks, faces_count);
 
-    ObjStruct load_from_string_lines(std::vector<std::string> const& lines) {
         std::vector<glm::vec3> v;
         std::vector<glm::vec2> vt;
         std::vector<glm::vec3> vn;
         std::vector<Face> f;
 
-        for (auto const& line : lines) {
-            if (line.rfind("v ", 0) == 0) {
-                auto vec = parse_vec3(line.substr(2));
-                v.push_back(vec);
-            }
-            else if (line.rfind("vt ", 0) == 0) {
-                auto vec = parse_vec2(line.substr(3));
-                vt.push_back(vec);
-            }
-            else if (line.rfind("vn ", 0) == 0) {
-                auto vec = parse_vec3(line.substr(3));
-                vn.push_back(vec);
+        v.reserve(total.v);
+        vt.reserve(total.vt);
+        vn.reserve(total.vn);
+        f.reserve(faces_count);
+
+        for (auto const& chunk : chunks) {
+            v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+            vt.insert(vt.end(), chunk.vt.begin(), chunk.vt.end());
+            vn.insert(vn.end(), chunk.vn.begin(), chunk.vn.end());
+
+            auto triplet = chunk.triplets.begin();
+
+            for (const auto size : chunk.face_sizes) {
+                f.emplace_back(std::vector<Triplet>(triplet, triplet + size));
+                triplet += size;
             }
-            else if (line.rfind("f ", 0) == 0) {
-                auto face = parse_face(line.substr(2));
-                f.push_back(face);
+        }
+
+        return ObjStruct(std::move(v), std::move(vt), std::move(vn), std::move(f));
+    }
+
+    // An index past max_elements can't refer to an element even before narrowing to index_t
+    static mesh::index_t to_layout_index(size_t index) {
+        if (index > mesh::max_elements) {
+            throw mesh::ValidationException();
+        }
+
+        return index == 0 ? mesh::absent_index : mesh::index_t(index - 1);
+    }
+
+    template<typename Iterator>
+    static void push_face(mesh::FaceTable& faces, Iterator begin, Iterator end) {
+        for (auto triplet = begin; triplet != end; ++triplet) {
+            faces.push_index(
+                to_layout_index(triplet->v),
+                to_layout_index(triplet->vn),
+                to_layout_index(triplet->vt),
+                mesh::absent_index
+            );
+        }
+
+        faces.end_face();
+    }
+
+    // Chunk storage is moved into the builder as is, faces go straight from
+    // the flat triplets to the face table without an intermediate ObjStruct
+    static std::shared_ptr<mesh::MeshLayout> build_mesh_layout(std::vector<Chunk>& chunks) {
+        size_t faces_count;
+        const auto total = resolve_chunks(chunks, faces_count);
+
+        size_t triplets_count = 0;
+
+        for (auto const& chunk : chunks) {
+            triplets_count += chunk.triplets.size();
+        }
+
+        mesh::check_index_capacity(total.v);
+        mesh::check_index_capacity(total.vt);
+        mesh::check_index_capacity(total.vn);
+        mesh::check_index_capacity(triplets_count);
+
+        mesh::MeshLayoutBuilder builder;
+        mesh::FaceTable faces;
+        faces.reserve(faces_count, triplets_count);
+
+        for (auto& chunk : chunks) {
+            builder.push_vertices(std::move(chunk.v));
+            builder.push_normals(std::move(chunk.vn));
+            builder.push_tex_coords(std::move(chunk.vt));
+
+            auto triplet = chunk.triplets.cbegin();
+
+            for (const auto size : chunk.face_sizes) {
+                push_face(faces, triplet, triplet + size);
+                triplet += size;
             }
+
+            chunk = Chunk();
         }
 
-        if (v.empty()) {
-            throw StructIsException();
+        builder.push_faces(std::move(faces));
+        return builder.build();
+    }
+
+    static std::vector<Chunk> parse_chunks(std::string_view data, size_t threads) {
+        const auto parts = split_into_chunks(data, threads);
+        std::vector<Chunk> chunks(parts.size());
+
+        utils::run_parallel(parts.size(), [&parts, &chunks](size_t index) {
+            parse_lines(parts[index], chunks[index]);
+        });
+
+        return chunks;
+    }
+
+    ObjStruct load_from_string_lines(std::vector<std::string> const& lines) {
+        std::vector<Chunk> chunks(1);
+
+        for (auto const& line : lines) {
+            parse_lines(line, chunks[0]);
         }
 
-        return ObjStruct(v, vt, vn, f);
+        return merge_chunks(chunks);
+    }
+
+    ObjStruct load_from_string(std::string_view data, size_t threads) {
+        auto chunks = parse_chunks(data, threads);
+        return merge_chunks(chunks);
+    }
+
+    ObjStruct load_from_file(std::string const& filepath, size_t threads) {
+        const utils::MappedFile file(filepath);
+        return load_from_string(file.view(), threads);
     }
 
-    static glm::vec3 parse_vec3(std::string const& line) {
-        auto components = utils::split(line, ' ');
+    std::shared_ptr<mesh::MeshLayout> load_mesh_layout_from_string(std::string_view data, size_t threads) {
+        auto chunks = parse_chunks(data, threads);
+        return build_mesh_layout(chunks);
+    }
+
+    std::shared_ptr<mesh::MeshLayout> load_mesh_layout_from_file(std::string const& filepath, size_t threads) {
+        const utils::MappedFile file(filepath);
+        return load_mesh_layout_from_string(file.view(), threads);
+    }
 
-        if (components.size() != 3) {
+    void stream_from_string(std::string_view data, ObjHandler& handler) {
+        HandlerSink sink(handler);
+        parse_lines(data, sink);
+    }
+
+    static glm::vec3 parse_vec3(LineTokens& tokens) {
+        const auto x = parse_float(tokens.next());
+        const auto y = parse_float(tokens.next());
+        const auto z = parse_float(tokens.next());
+
+        if (!tokens.next().text.empty()) {
             throw ParseException();
         }
 
-        return glm::vec3(
-            std::stof(components[0]),
-            std::stof(components[1]),
-            std::stof(components[2])
-        );
+        return glm::vec3(x, y, z);
     }
 
-    static glm::vec2 parse_vec2(std::string const& line) {
-        auto components = utils::split(line, ' ');
+    static glm::vec2 parse_vec2(LineTokens& tokens) {
+        const auto x = parse_float(tokens.next());
+        const auto y = parse_float(tokens.next());
 
-        if (components.size() != 2) {
+        if (!tokens.next().text.empty()) {
             throw ParseException();
         }
 
-        return glm::vec2(
-            std::stof(components[0]),
-            std::stof(components[1])
-        );
+        return glm::vec2(x, y);
     }
 
-    static Face parse_face(std::string const& line) {
-        auto triplets_str = utils::split(line, ' ');
-        std::vector<Triplet> triplets;
-        triplets.reserve(triplets_str.size());
+    template<typename Sink>
+    static void parse_face(LineTokens& tokens, Sink& sink) {
+        size_t size = 0;
+
+        for (auto token = tokens.next(); !token.text.empty(); token = tokens.next()) {
+            sink.push_triplet(parse_triplet(token, sink));
+            size++;
+        }
+
+        sink.push_face(size);
+    }
+
+    // Supported forms: v, v/vt, v//vn, v/vt/vn
+    template<typename Sink>
+    static Triplet parse_triplet(Token const& token, Sink& sink) {
+        if (token.slashes_count > token.slashes.size()) {
+            throw ParseException();
+        }
+
+        const auto text = token.text;
+        const auto v_end = token.slashes_count > 0 ? token.slashes[0] : text.size();
+        const auto v = parse_index(text.substr(0, v_end), Component::V, sink);
+        size_t vt = 0;
+        size_t vn = 0;
+
+        if (token.slashes_count > 0) {
+            const auto vt_end = token.slashes_count > 1 ? token.slashes[1] : text.size();
+            const auto vt_str = text.substr(v_end + 1, vt_end - v_end - 1);
+
+            // "v/" is malformed, "v//vn" has no tex coord
+            if (vt_str.empty() && token.slashes_count == 1) {
+                throw ParseException();
+            }
+
+            if (!vt_str.empty()) {
+                vt = parse_index(vt_str, Component::VT, sink);
+            }
+        }
 
-        for (auto const& triplet : triplets_str) {
-            triplets.push_back(parse_triplet(triplet));
+        if (token.slashes_count > 1) {
+            vn = parse_index(text.substr(token.slashes[1] + 1), Component::VN, sink);
         }
 
-        return Face(triplets);
+        return Triplet(v, vt, vn);
     }
 
-    static Triplet parse_triplet(std::string const& line) {
-        auto components = utils::split(line, '/');
+    // Parse 1-based index, relative (negative) indices are left to the sink to resolve
+    template<typename Sink>
+    static size_t parse_index(std::string_view str, Component component, Sink& sink) {
+        const bool negative = !str.empty() && str.front() == '-';
 
-        if (components.size() != 3) {
+        if (negative) {
+            str.remove_prefix(1);
+        }
+
+        if (str.empty() || !is_digit(str.front())) {
+            throw ParseException();
+        }
+
+        size_t value = 0;
+
+        while (!str.empty() && is_digit(str.front())) {
+            const auto digit = static_cast<size_t>(str.front() - '0');
+
+            if (value > (std::numeric_limits<size_t>::max() - digit) / 10) {
+                throw ParseException();
+            }
+
+            value = value * 10 + digit;
+            str.remove_prefix(1);
+        }
+
+        if (value == 0 || !str.empty()) {
             throw ParseException();
         }
 
-        return Triplet(
-            std::stoi(components[0]),
-            parse_optional_index(components[1]),
-            parse_optional_index(components[2])
-        );
+        if (negative) {
+            return sink.relative_index(value, component);
+        }
+
+        return value;
     }
 
-    static size_t parse_optional_index(std::string const& str) {
-        if (str.empty()) {
-            return 0;
+    static float parse_float_fallback(std::string_view token) {
+        // strtof requires a null terminated string
+        std::array<char, 64> buffer {};
+
+        if (token.size() >= buffer.size()) {
+            throw ParseException();
         }
-        else {
-            return std::stoi(str);
+
+        std::copy(token.begin(), token.end(), buffer.begin());
+
+        char* parsed_end = nullptr;
+        const float value = std::strtof(buffer.data(), &parsed_end);
+
+        if (parsed_end != buffer.data() + token.size()) {
+            throw ParseException();
         }
+
+        return value;
     }
 
-    std::shared_ptr<mesh::MeshLayout> create_mesh_layout_from_obj(ObjStruct const& obj) {
-        auto builder = std::make_unique<mesh::MeshLayoutBuilder>();
+    // Fast path: when both the decimal mantissa and the power of ten are exactly
+    // representable in float a single multiplication or division gives the correctly
+    // rounded result (Clinger's fast path). Everything else goes through strtof.
+    static float parse_float(Token const& number) {
+        static constexpr std::array<float, 11> powers_of_ten {
+            1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+        };
+
+        static constexpr uint64_t max_exact_mantissa = uint64_t(1) << 24;
 
-        for (auto v : obj.v) {
-            builder->push_vertex(v);
+        const auto token = number.text;
+
+        if (token.empty() || number.slashes_count > 0) {
+            throw ParseException();
         }
 
-        for (auto vn : obj.vn) {
-            builder->push_normal(vn);
+        size_t pos = 0;
+        const bool negative = token[pos] == '-';
+
+        if (token[pos] == '-' || token[pos] == '+') {
+            pos++;
         }
 
-        for (auto vt : obj.vt) {
-            builder->push_tex_coord(vt);
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        size_t digits = 0;
+
+        for (; pos < token.size() && is_digit(token[pos]); pos++, digits++) {
+            if (mantissa <= max_exact_mantissa) {
+                mantissa = mantissa * 10 + (token[pos] - '0');
+            }
+            else {
+                return parse_float_fallback(token);
+            }
         }
 
-        std::vector<mesh::TripletFace> faces;
-        faces.reserve(obj.f.size());
+        if (pos < token.size() && token[pos] == '.') {
+            pos++;
+
+            for (; pos < token.size() && is_digit(token[pos]); pos++, digits++) {
+                if (mantissa <= max_exact_mantissa) {
+                    mantissa = mantissa * 10 + (token[pos] - '0');
+                    exponent--;
+                }
+                else {
+                    return parse_float_fallback(token);
+                }
+            }
+        }
+
+        if (pos < token.size() && (token[pos] == 'e' || token[pos] == 'E')) {
+            pos++;
+
+            const bool negative_exponent = pos < token.size() && token[pos] == '-';
 
-        for (auto const& f : obj.f) {
-            std::vector<mesh::Triplet> triplets;
-            triplets.reserve(obj.f.size());
+            if (pos < token.size() && (token[pos] == '-' || token[pos] == '+')) {
+                pos++;
+            }
+
+            int explicit_exponent = 0;
+            const auto exponent_start = pos;
+
+            for (; pos < token.size() && is_digit(token[pos]) && explicit_exponent < 1000; pos++) {
+                explicit_exponent = explicit_exponent * 10 + (token[pos] - '0');
+            }
 
-            for (auto triplet : f.triplets) {
-                triplets.emplace_back(
-                    triplet.v == 0 ? mesh::absent_index : triplet.v - 1,
-                    triplet.vn == 0 ? mesh::absent_index : triplet.vn - 1,
-                    triplet.vt == 0 ? mesh::absent_index : triplet.vt - 1
-                );
+            if (pos == exponent_start) {
+                throw ParseException();
             }
 
-            faces.emplace_back(triplets);
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
         }
 
-        for (auto const& face : faces) {
-            builder->push_triplet_face(face);
+        // Anything unusual (inf, nan, hex floats, ...) is handled by strtof
+        if (digits == 0 || pos != token.size()) {
+            return parse_float_fallback(token);
+        }
+
+        if (mantissa > max_exact_mantissa || exponent < -10 || exponent > 10) {
+            return parse_float_fallback(token);
+        }
+
+        float value = static_cast<float>(mantissa);
+
+        if (exponent < 0) {
+            value /= powers_of_ten[-exponent];
+        }
+        else {
+            value *= powers_of_ten[exponent];
+        }
+
+        return negative ? -value : value;
+    }
+
+    std::shared_ptr<mesh::MeshLayout> create_mesh_layout_from_obj(ObjStruct const& obj) {
+        auto builder = std::make_unique<mesh::MeshLayoutBuilder>();
+
+        builder->push_vertices(obj.v());
+        builder->push_normals(obj.vn());
+        builder->push_tex_coords(obj.vt());
+
+        mesh::FaceTable faces;
+        faces.reserve(obj.f().size(), obj.f().size() * 3);
+
+        for (auto const& f : obj.f()) {
+            push_face(faces, f.triplets().cbegin(), f.triplets().cend());
         }
 
+        builder->push_faces(std::move(faces));
         return builder->build();
     }
 }
@@ -0,0 +1,159 @@
+#include "format.hpp"
+
+#include <cerrno>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace mesh_format {
+
+    void MemorySink::write(const std::byte* data, size_t size) {
+        const auto chars = reinterpret_cast<const char*>(data);
+        this->data.insert(this->data.end(), chars, chars + size);
+    }
+
+    std::byte* MemorySink::allocate(size_t size) {
+        const auto offset = this->data.size();
+        this->data.resize(offset + size);
+        return reinterpret_cast<std::byte*>(this->data.data() + offset);
+    }
+
+    std::vector<char> MemorySink::release() {
+        return std::move(this->data);
+    }
+
+    FileSink::FileSink(std::string const& filepath, size_t buffer_size) :
+        filepath(filepath),
+        buffer_size(buffer_size)
+    {
+        this->fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (this->fd < 0) {
+            throw std::ofstream::failure("can't open file '" + filepath + "'");
+        }
+
+        this->buffer.reserve(buffer_size);
+    }
+
+    FileSink::~FileSink() {
+        if (this->fd < 0) {
+            return;
+        }
+
+        try {
+            this->close();
+        }
+        catch (std::ofstream::failure const& e) {
+            // Nothing
+        }
+    }
+
+    void FileSink::write(const std::byte* data, size_t size) {
+        this->unmap();
+
+        if (this->buffer.size() + size > this->buffer_size) {
+            this->flush();
+        }
+
+        // Copying a chunk as large as the buffer saves nothing
+        if (size >= this->buffer_size) {
+            this->write_to_file(data, size);
+            return;
+        }
+
+        this->buffer.insert(this->buffer.end(), data, data + size);
+    }
+
+    std::byte* FileSink::allocate(size_t size) {
+        this->unmap();
+        this->flush();
+
+        if (size == 0) {
+            return nullptr;
+        }
+
+        const auto offset = ::lseek(this->fd, 0, SEEK_CUR);
+
+        if (offset < 0) {
+            throw std::ofstream::failure("can't seek file '" + this->filepath + "'");
+        }
+
+        // Unlike a sparse ftruncate, allocated blocks can't fail with SIGBUS on a full disk when the mapping is written
+        if (::posix_fallocate(this->fd, offset, off_t(size)) != 0) {
+            throw std::ofstream::failure("can't allocate file '" + this->filepath + "'");
+        }
+
+        // The next writes follow the allocated bytes
+        if (::lseek(this->fd, offset + off_t(size), SEEK_SET) < 0) {
+            throw std::ofstream::failure("can't seek file '" + this->filepath + "'");
+        }
+
+        // Mappings start at a page boundary
+        const auto page_offset = offset % ::sysconf(_SC_PAGESIZE);
+        const auto length = size + size_t(page_offset);
+        void* data = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, offset - page_offset);
+
+        if (data == MAP_FAILED) {
+            throw std::ofstream::failure("can't map file '" + this->filepath + "'");
+        }
+
+        this->mapped = data;
+        this->mapped_length = length;
+
+        return static_cast<std::byte*>(data) + page_offset;
+    }
+
+    void FileSink::close() {
+        const int fd = this->fd;
+
+        try {
+            this->unmap();
+            this->flush();
+        }
+        catch (...) {
+            ::close(fd);
+            this->fd = -1;
+            throw;
+        }
+
+        this->fd = -1;
+
+        if (::close(fd) != 0) {
+            throw std::ofstream::failure("can't close file '" + this->filepath + "'");
+        }
+    }
+
+    void FileSink::unmap() {
+        if (this->mapped != nullptr) {
+            ::munmap(this->mapped, this->mapped_length);
+            this->mapped = nullptr;
+            this->mapped_length = 0;
+        }
+    }
+
+    void FileSink::flush() {
+        this->write_to_file(this->buffer.data(), this->buffer.size());
+        this->buffer.clear();
+    }
+
+    // write may take only a part of the data or be interrupted by a signal
+    void FileSink::write_to_file(const std::byte* data, size_t size) {
+        while (size > 0) {
+            const auto written = ::write(this->fd, data, size);
+
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (written <= 0) {
+                throw std::ofstream::failure("can't write file '" + this->filepath + "'");
+            }
+
+            data += written;
+            size -= size_t(written);
+        }
+    }
+
+}
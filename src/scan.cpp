@@ -0,0 +1,203 @@
+#include "scan.hpp"
+
+#include <algorithm>
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace scan {
+
+    static BlockMasks classify_block_scalar(const char* block) {
+        BlockMasks masks {0, 0, 0};
+
+        for (size_t i = 0; i < block_size; i++) {
+            const uint64_t bit = uint64_t(1) << i;
+
+            switch (block[i]) {
+                case '\n':
+                    masks.newlines |= bit;
+                    break;
+
+                case ' ':
+                case '\t':
+                    masks.spaces |= bit;
+                    break;
+
+                case '/':
+                    masks.slashes |= bit;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        return masks;
+    }
+
+#ifdef SCAN_X86
+    __attribute__((target("sse2")))
+    static uint64_t compare_sse2(const __m128i* chunks, char ch) {
+        const auto pattern = _mm_set1_epi8(ch);
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < 4; i++) {
+            const auto bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], pattern)));
+            mask |= uint64_t(bits) << (i * 16);
+        }
+
+        return mask;
+    }
+
+    __attribute__((target("sse2")))
+    static BlockMasks classify_block_sse2(const char* block) {
+        const __m128i chunks[4] {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48))
+        };
+
+        return {
+            compare_sse2(chunks, '\n'),
+            compare_sse2(chunks, ' ') | compare_sse2(chunks, '\t'),
+            compare_sse2(chunks, '/')
+        };
+    }
+
+    __attribute__((target("avx2")))
+    static uint64_t compare_avx2(__m256i low, __m256i high, char ch) {
+        const auto pattern = _mm256_set1_epi8(ch);
+        const auto low_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, pattern)));
+        const auto high_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, pattern)));
+
+        return uint64_t(low_bits) | (uint64_t(high_bits) << 32);
+    }
+
+    __attribute__((target("avx2")))
+    static BlockMasks classify_block_avx2(const char* block) {
+        const auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        const auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+        return {
+            compare_avx2(low, high, '\n'),
+            compare_avx2(low, high, ' ') | compare_avx2(low, high, '\t'),
+            compare_avx2(low, high, '/')
+        };
+    }
+#endif
+
+    bool is_supported(Isa isa) {
+        switch (isa) {
+            case Isa::Scalar:
+                return true;
+
+#ifdef SCAN_X86
+            case Isa::Sse2:
+                return __builtin_cpu_supports("sse2");
+
+            case Isa::Avx2:
+                return __builtin_cpu_supports("avx2");
+#endif
+
+            default:
+                return false;
+        }
+    }
+
+    Isa best_isa() {
+        static const Isa isa = [] {
+            if (is_supported(Isa::Avx2)) {
+                return Isa::Avx2;
+            }
+
+            if (is_supported(Isa::Sse2)) {
+                return Isa::Sse2;
+            }
+
+            return Isa::Scalar;
+        }();
+
+        return isa;
+    }
+
+    BlockMasks classify_block(const char* block, Isa isa) {
+        switch (isa) {
+#ifdef SCAN_X86
+            case Isa::Avx2:
+                return classify_block_avx2(block);
+
+            case Isa::Sse2:
+                return classify_block_sse2(block);
+#endif
+
+            default:
+                return classify_block_scalar(block);
+        }
+    }
+
+    void LineScanner::load_block(size_t start) {
+        this->block_start = start;
+        this->block_loaded = true;
+
+        if (start + block_size <= this->text.size()) {
+            this->masks = classify_block(this->text.data() + start, this->isa);
+        }
+        else {
+            // Tail is copied into a zeroed block, so nothing is read past the end of text
+            std::array<char, block_size> tail {};
+            std::copy(this->text.begin() + start, this->text.end(), tail.begin());
+            this->masks = classify_block(tail.data(), this->isa);
+        }
+    }
+
+    static void push_offsets(uint64_t mask, size_t block_start, size_t line_start, std::vector<uint32_t>& offsets) {
+        while (mask != 0) {
+            offsets.push_back(static_cast<uint32_t>(block_start + __builtin_ctzll(mask) - line_start));
+            mask &= mask - 1;
+        }
+    }
+
+    bool LineScanner::next_line(std::string_view& line, std::vector<uint32_t>& delimiters) {
+        if (this->position >= this->text.size()) {
+            return false;
+        }
+
+        const auto line_start = this->position;
+        delimiters.clear();
+
+        while (this->position < this->text.size()) {
+            const auto start = this->position - this->position % block_size;
+
+            if (!this->block_loaded || start != this->block_start) {
+                this->load_block(start);
+            }
+
+            const auto shift = this->position - start;
+            const uint64_t from_position = ~uint64_t(0) << shift;
+            const uint64_t newlines = this->masks.newlines & from_position;
+            const uint64_t block_delimiters = (this->masks.spaces | this->masks.slashes) & from_position;
+
+            if (newlines != 0) {
+                const auto newline = static_cast<size_t>(__builtin_ctzll(newlines));
+                const uint64_t before_newline = (uint64_t(1) << newline) - 1;
+
+                push_offsets(block_delimiters & before_newline, start, line_start, delimiters);
+
+                line = this->text.substr(line_start, start + newline - line_start);
+                this->position = start + newline + 1;
+                return true;
+            }
+
+            push_offsets(block_delimiters, start, line_start, delimiters);
+            this->position = start + block_size;
+        }
+
+        line = this->text.substr(line_start);
+        return true;
+    }
+
+}
@@ -1,45 +1,467 @@
 #include "stl.hpp"
 #include "utils.hpp"
+#include "normals.hpp"
+
+#include <array>
+#include <charconv>
+#include <condition_variable>
+#include <limits>
+#include <numeric>
+#include <cstring>
+#include <mutex>
+#include <string_view>
 
 namespace stl_file {
 
+    static constexpr size_t header_size = 80;
+
+    static constexpr size_t stream_buffer_size = 1 << 20;
+
+    // Normal, three vertices and the attribute byte count
+    static constexpr size_t triangle_size = 50;
+
+    // Fewer triangles per thread aren't worth starting the thread for
+    static constexpr size_t min_triangles_per_thread = 16384;
+
+    static constexpr std::string_view text_header = "solid mesh\n";
+
+    static constexpr std::string_view text_footer = "endsolid mesh\n";
+
+    // The shortest form of a float is at most 14 chars, like -1.1754944e-38
+    static constexpr size_t max_text_float_size = 16;
+
+    // Keywords, indentation and 12 floats of a facet
+    static constexpr size_t max_text_triangle_size = 320;
+
+    static void write_header(mesh_format::BytesWriter& writer) {
+        std::vector<std::byte> bytes(header_size);
+        writer.write_bytes(bytes);
+    }
+
+    // REAL32[3] – Normal vector, then REAL32[3] for each of the vertices
+    static std::array<float, 12> get_triangle_values(mesh::Triangle const& triangle) {
+        auto const& vertices = triangle.vertices();
+        auto normal = triangle.normal().value_or(
+            utils::calculate_normal(vertices[0], vertices[1], vertices[2])
+        );
+
+        return {
+            normal.x, normal.y, normal.z,
+            vertices[0].x, vertices[0].y, vertices[0].z,
+            vertices[1].x, vertices[1].y, vertices[1].z,
+            vertices[2].x, vertices[2].y, vertices[2].z,
+        };
+    }
+
+    // Triangles are gathered into blocks, so the missing normals of a block are computed by one call of the batch kernel
+    class TriangleBatch {
+    public:
+        // Returns true when the batch is full
+        bool add(mesh::Triangle const& triangle) {
+            auto const& vertices = triangle.vertices();
+            auto& values = this->values[this->count];
+
+            for (size_t corner = 0; corner < 3; corner++) {
+                const auto vertex = vertices[corner];
+                const std::array<float, 3> coordinates {vertex.x, vertex.y, vertex.z};
+
+                for (size_t axis = 0; axis < 3; axis++) {
+                    values[3 + 3 * corner + axis] = coordinates[axis];
+                    this->triangles.corners[3 * corner + axis][this->count] = coordinates[axis];
+                }
+            }
+
+            this->has_normal[this->count] = triangle.normal().has_value();
+
+            if (triangle.normal()) {
+                values[0] = triangle.normal()->x;
+                values[1] = triangle.normal()->y;
+                values[2] = triangle.normal()->z;
+            }
+            else {
+                this->missing_normals = true;
+            }
+
+            this->count++;
+
+            return this->count == normals::block_size;
+        }
+
+        // Calls callback with the values of every triangle in order, see get_triangle_values, and empties the batch
+        template<typename Callback>
+        void drain(Callback const& callback) {
+            if (this->missing_normals) {
+                normals::calculate_normals(this->triangles, this->normals, this->isa);
+            }
+
+            for (size_t i = 0; i < this->count; i++) {
+                auto& values = this->values[i];
+
+                if (!this->has_normal[i]) {
+                    values[0] = this->normals.axes[0][i];
+                    values[1] = this->normals.axes[1][i];
+                    values[2] = this->normals.axes[2][i];
+                }
+
+                callback(values.data());
+            }
+
+            this->count = 0;
+            this->missing_normals = false;
+        }
+
+    private:
+        normals::Isa isa = normals::best_isa();
+
+        // Lanes past the count keep the previous triangles, their normals are computed and ignored
+        normals::TriangleBlock triangles {};
+        normals::NormalBlock normals {};
+        std::array<std::array<float, 12>, normals::block_size> values {};
+        std::array<bool, normals::block_size> has_normal {};
+        size_t count = 0;
+        bool missing_normals = false;
+    };
+
+    template<typename Callback>
+    static void for_each_triangle_values(const mesh::Triangle* triangles, size_t count, Callback const& callback) {
+        TriangleBatch batch;
+
+        for (size_t i = 0; i < count; i++) {
+            if (batch.add(triangles[i])) {
+                batch.drain(callback);
+            }
+        }
+
+        batch.drain(callback);
+    }
+
+    // Values of the triangles of the reader parts [begin, end) a block at a time,
+    // can be called for disjoint parts from several threads
+    template<typename Callback>
+    static void for_each_triangle_values(mesh::MeshLayoutReader& reader, size_t begin, size_t end, Callback const& callback) {
+        TriangleBatch batch;
+
+        reader.for_each_triangle(begin, end, [&](mesh::Triangle const& triangle) {
+            if (batch.add(triangle)) {
+                batch.drain(callback);
+            }
+        });
+
+        batch.drain(callback);
+    }
+
+    static void write_triangle(mesh_format::BytesWriter& writer, const float* values) {
+        // UINT16 – Attribute byte count
+        writer.write_record(values, 12, 2);
+    }
+
+    // Same bytes as write_triangle, stored to the output instead of appended to a writer
+    static void encode_triangle(std::byte* output, const float* values, bool swap_endian) {
+        constexpr size_t values_size = 12 * sizeof(float);
+
+        static_assert(values_size + 2 == triangle_size);
+
+        std::memcpy(output, values, values_size);
+
+        if (swap_endian) {
+            for (size_t i = 0; i < values_size; i += sizeof(float)) {
+                std::reverse(output + i, output + i + sizeof(float));
+            }
+        }
+
+        // UINT16 – Attribute byte count
+        output[values_size] = std::byte(0x00);
+        output[values_size + 1] = std::byte(0x00);
+    }
+
+    static char* encode_text(char* output, std::string_view text) {
+        std::memcpy(output, text.data(), text.size());
+        return output + text.size();
+    }
+
+    static char* encode_text_floats(char* output, const float* values) {
+        for (size_t i = 0; i < 3; i++) {
+            *output++ = ' ';
+            output = std::to_chars(output, output + max_text_float_size, values[i]).ptr;
+        }
+
+        *output++ = '\n';
+        return output;
+    }
+
+    // Writes at most max_text_triangle_size chars, returns the number of them
+    static size_t encode_text_triangle(char* output, const float* values) {
+        const auto begin = output;
+
+        output = encode_text(output, "  facet normal");
+        output = encode_text_floats(output, values);
+        output = encode_text(output, "    outer loop\n");
+
+        for (size_t i = 1; i < 4; i++) {
+            output = encode_text(output, "      vertex");
+            output = encode_text_floats(output, values + 3 * i);
+        }
+
+        output = encode_text(output, "    endloop\n  endfacet\n");
+
+        return size_t(output - begin);
+    }
+
     void StlMeshWriter::write_layout() {
+        const auto triangles_count = this->layout_reader->triangles_count();
+
+        if (triangles_count > std::numeric_limits<uint32_t>::max()) {
+            throw TooManyTrianglesException();
+        }
+
+        // The writer holds at most a chunk before it's passed to the sink
+        this->writer->reserve(header_size + sizeof(uint32_t) +
+            std::min(triangles_count, mesh_format::sink_chunk_size / triangle_size + block_size) * triangle_size);
+
         this->write_header();
-        MeshWriter::write_triangles();
+        this->writer->write_uint32_t(static_cast<uint32_t>(triangles_count));
+
+        if (!this->write_triangles_parallel(triangles_count)) {
+            this->write_triangles();
+        }
+    }
+
+    void StlMeshWriter::write_triangle_block(const mesh::Triangle* triangles, size_t count) {
+        for_each_triangle_values(triangles, count, [this](const float* values) {
+            ::stl_file::write_triangle(*this->writer, values);
+        });
+    }
+
+    bool StlMeshWriter::write_triangles_parallel(size_t triangles_count) {
+        const auto chunks_count = std::min(this->threads, triangles_count / min_triangles_per_thread);
+
+        if (chunks_count < 2) {
+            return false;
+        }
+
+        // The header goes before the allocated triangles
+        this->flush_to_sink(true);
+
+        const auto output = this->sink->allocate(triangles_count * triangle_size);
+
+        if (output == nullptr) {
+            return false;
+        }
+
+        // Stl is little endian
+        const bool swap_endian = utils::is_big_endian();
+
+        // Threads take consecutive parts of the reader, their triangles go after the ones of the previous chunks
+        auto& reader = *this->layout_reader;
+        const auto parts_count = reader.parts_count();
+        const auto get_first_part = [&](size_t chunk) { return parts_count * chunk / chunks_count; };
+        std::vector<size_t> offsets(chunks_count + 1, 0);
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            offsets[chunk + 1] = reader.triangles_count(get_first_part(chunk), get_first_part(chunk + 1));
+        });
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        utils::run_parallel(chunks_count, [&](size_t chunk) {
+            auto triangle_output = output + offsets[chunk] * triangle_size;
+
+            for_each_triangle_values(reader, get_first_part(chunk), get_first_part(chunk + 1), [&](const float* values) {
+                encode_triangle(triangle_output, values, swap_endian);
+                triangle_output += triangle_size;
+            });
+        });
+
+        return true;
     }
 
     void StlMeshWriter::write_header() {
-        std::vector<std::byte> bytes(80);
-        this->writer->write_bytes(bytes);
+        ::stl_file::write_header(*this->writer);
+    }
+
+    StlStreamWriter::StlStreamWriter(std::string const& filepath) :
+        writer(mesh_format::FileType::Binary, mesh_format::ByteOrder::LittleEndian)
+    {
+        this->stream.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        this->stream.open(filepath, std::ios::out | std::ios::binary);
+
+        // Triangles count is unknown yet, it's patched on finish
+        ::stl_file::write_header(this->writer);
+        this->writer.write_uint32_t(0);
+    }
+
+    void StlStreamWriter::write_triangle(mesh::Triangle const& triangle) {
+        if (this->triangles_count == std::numeric_limits<uint32_t>::max()) {
+            throw TooManyTrianglesException();
+        }
+
+        ::stl_file::write_triangle(this->writer, get_triangle_values(triangle).data());
+        this->triangles_count++;
+
+        if (this->writer.get_bytes().size() >= stream_buffer_size) {
+            this->flush();
+        }
     }
 
-    void StlMeshWriter::write_triangles(std::vector<mesh::Triangle> const& triangles) {
-        this->writer->write_int32_t(static_cast<int32_t>(triangles.size()));
-        MeshWriter::write_triangles(triangles);
+    void StlStreamWriter::finish() {
+        this->flush();
+
+        this->writer.write_uint32_t(this->triangles_count);
+        this->stream.seekp(header_size);
+        this->flush();
+        this->stream.close();
+    }
+
+    uint32_t StlStreamWriter::get_triangles_count() const {
+        return this->triangles_count;
     }
 
-    void StlMeshWriter::write_triangle(mesh::Triangle const& triangle) {
-        // REAL32[3] – Normal vector
-        auto normal = triangle.normal.value_or(
-            utils::calculate_normal(
-                triangle.vertices[0],
-                triangle.vertices[1],
-                triangle.vertices[2]
-            )
+    void StlStreamWriter::flush() {
+        auto const& bytes = this->writer.get_bytes();
+
+        this->stream.write(
+            reinterpret_cast<const char*>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size())
         );
 
-        this->writer->write_float(normal.x);
-        this->writer->write_float(normal.y);
-        this->writer->write_float(normal.z);
+        this->writer.clear();
+    }
+
+    void StlTextMeshWriter::write_header() {
+        this->writer->write_chars(text_header.data(), text_header.size());
+    }
+
+    void StlTextMeshWriter::write_layout() {
+        const auto triangles_count = this->layout_reader->triangles_count();
+
+        // The writer holds at most a chunk before it's passed to the sink
+        this->writer->reserve(text_header.size() + text_footer.size() +
+            std::min(triangles_count * max_text_triangle_size, mesh_format::sink_chunk_size + block_size * max_text_triangle_size));
 
-        // Vertices
-        for (auto vertex : triangle.vertices) {
-            this->writer->write_float(vertex.x);
-            this->writer->write_float(vertex.y);
-            this->writer->write_float(vertex.z);
+        this->write_header();
+
+        if (!this->write_triangles_parallel(triangles_count)) {
+            this->write_triangles();
         }
 
-        // UINT16 – Attribute byte count
-        this->writer->write_bytes({std::byte(0x00), std::byte(0x00)});
+        this->writer->write_chars(text_footer.data(), text_footer.size());
+    }
+
+    void StlTextMeshWriter::write_triangle_block(const mesh::Triangle* triangles, size_t count) {
+        std::array<char, max_text_triangle_size> chars;
+
+        for_each_triangle_values(triangles, count, [&](const float* values) {
+            this->writer->write_chars(chars.data(), encode_text_triangle(chars.data(), values));
+        });
+    }
+
+    bool StlTextMeshWriter::write_triangles_parallel(size_t triangles_count) {
+        const auto chunks_count = std::min(this->threads, triangles_count / min_triangles_per_thread);
+
+        if (chunks_count < 2) {
+            return false;
+        }
+
+        // The header goes before the triangles
+        this->flush_to_sink(true);
+
+        // Batches are parts of the reader, a part has at least one triangle unless it's a degenerate face
+        auto& reader = *this->layout_reader;
+        const auto parts_count = reader.parts_count();
+        const auto batch_size = chunks_count * min_triangles_per_thread;
+        const auto batches_count = (parts_count + batch_size - 1) / batch_size;
+
+        // Workers are spawned once, each encodes its chunk of every batch. A worker has two buffers,
+        // it encodes the next batch into one while the other is written to the sink by the last thread,
+        // buffers are reused by the batches, so only the first two allocate
+        std::vector<std::array<std::vector<char>, 2>> buffers(chunks_count);
+        std::vector<std::array<size_t, 2>> sizes(chunks_count);
+
+        std::mutex mutex;
+        std::condition_variable encoded_condition;
+        std::condition_variable written_condition;
+        std::vector<size_t> encoded_batches(chunks_count, 0);
+        size_t written_batches = 0;
+        bool failed = false;
+
+        const auto encode = [&](size_t chunk) {
+            for (size_t batch = 0; batch < batches_count; batch++) {
+                {
+                    // The buffer of the batch is free once the batch before the previous one is written
+                    std::unique_lock<std::mutex> lock(mutex);
+                    written_condition.wait(lock, [&] { return failed || batch < written_batches + 2; });
+
+                    if (failed) {
+                        return;
+                    }
+                }
+
+                const auto first_part = batch * batch_size;
+                const auto batch_count = std::min(batch_size, parts_count - first_part);
+                const size_t begin = first_part + batch_count * chunk / chunks_count;
+                const size_t end = first_part + batch_count * (chunk + 1) / chunks_count;
+                const auto capacity = reader.triangles_count(begin, end) * max_text_triangle_size;
+                auto& buffer = buffers[chunk][batch % 2];
+
+                if (buffer.size() < capacity) {
+                    buffer.resize(capacity);
+                }
+
+                size_t size = 0;
+
+                for_each_triangle_values(reader, begin, end, [&](const float* values) {
+                    size += encode_text_triangle(buffer.data() + size, values);
+                });
+
+                sizes[chunk][batch % 2] = size;
+
+                const std::lock_guard<std::mutex> lock(mutex);
+                encoded_batches[chunk] = batch + 1;
+                encoded_condition.notify_all();
+            }
+        };
+
+        const auto write = [&]() {
+            for (size_t batch = 0; batch < batches_count; batch++) {
+                for (size_t chunk = 0; chunk < chunks_count; chunk++) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        encoded_condition.wait(lock, [&] { return failed || encoded_batches[chunk] > batch; });
+
+                        if (failed) {
+                            return;
+                        }
+                    }
+
+                    const auto& buffer = buffers[chunk][batch % 2];
+                    this->sink->write(reinterpret_cast<const std::byte*>(buffer.data()), sizes[chunk][batch % 2]);
+                }
+
+                const std::lock_guard<std::mutex> lock(mutex);
+                written_batches = batch + 1;
+                written_condition.notify_all();
+            }
+        };
+
+        utils::run_parallel(chunks_count + 1, [&](size_t index) {
+            try {
+                if (index < chunks_count) {
+                    encode(index);
+                }
+                else {
+                    write();
+                }
+            }
+            // The other threads would wait for this one forever
+            catch (...) {
+                const std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                encoded_condition.notify_all();
+                written_condition.notify_all();
+                throw;
+            }
+        });
+
+        return true;
     }
 }
@@ -0,0 +1,209 @@
+#include "stl.hpp"
+#include "calc.hpp"
+
+#include <array>
+#include <cstring>
+#include <numeric>
+
+namespace stl_file {
+
+    static constexpr size_t header_size = 80;
+
+    // Normal, three vertices and the attribute byte count
+    static constexpr size_t triangle_size = 50;
+
+    static constexpr size_t triangle_floats_count = 12;
+
+    static bool is_space(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f' || ch == '\v';
+    }
+
+    // Splits the text by whitespace
+    class TextTokens {
+    public:
+        explicit TextTokens(std::string_view text) : text(text) {}
+
+        // Empty at the end of the text
+        std::string_view next() {
+            while (this->position < this->text.size() && is_space(this->text[this->position])) {
+                this->position++;
+            }
+
+            const auto start = this->position;
+
+            while (this->position < this->text.size() && !is_space(this->text[this->position])) {
+                this->position++;
+            }
+
+            return this->text.substr(start, this->position - start);
+        }
+
+    private:
+        std::string_view text;
+        size_t position = 0;
+    };
+
+    static float parse_float(std::string_view token) {
+        // strtof requires a null terminated string
+        std::array<char, 64> buffer {};
+
+        if (token.empty() || token.size() >= buffer.size()) {
+            throw ParseException();
+        }
+
+        std::copy(token.begin(), token.end(), buffer.begin());
+
+        char* parsed_end = nullptr;
+        const float value = std::strtof(buffer.data(), &parsed_end);
+
+        if (parsed_end != buffer.data() + token.size()) {
+            throw ParseException();
+        }
+
+        return value;
+    }
+
+    static void parse_floats(TextTokens& tokens, float* values) {
+        for (size_t i = 0; i < 3; i++) {
+            values[i] = parse_float(tokens.next());
+        }
+    }
+
+    static bool is_binary(std::string_view data) {
+        if (data.size() < header_size + sizeof(uint32_t)) {
+            return false;
+        }
+
+        // Little endian regardless of the host
+        uint32_t count = 0;
+
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            count |= uint32_t(uint8_t(data[header_size + i])) << (8 * i);
+        }
+
+        return data.size() == header_size + sizeof(uint32_t) + size_t(count) * triangle_size;
+    }
+
+    // Binary headers are free text and may start with "solid" too, so the size is checked first
+    static bool is_text(std::string_view data) {
+        TextTokens tokens(data);
+        return tokens.next() == "solid";
+    }
+
+    StlTriangleView::StlTriangleView(std::string const& filepath) : file(filepath) {
+        const auto data = this->file.view();
+
+        if (is_binary(data)) {
+            this->records = data.data() + header_size + sizeof(uint32_t);
+            this->count = (data.size() - header_size - sizeof(uint32_t)) / triangle_size;
+            this->swap_endian = utils::is_big_endian();
+        }
+        else if (is_text(data)) {
+            this->parse_text(data);
+        }
+        else {
+            throw ParseException();
+        }
+    }
+
+    // Facets are stored as binary records in the host byte order
+    void StlTriangleView::parse_text(std::string_view text) {
+        TextTokens tokens(text);
+        std::array<float, triangle_floats_count> values {};
+        size_t vertices_count = 0;
+        bool in_facet = false;
+
+        for (auto token = tokens.next(); !token.empty(); token = tokens.next()) {
+            if (token == "facet") {
+                if (in_facet || tokens.next() != "normal") {
+                    throw ParseException();
+                }
+
+                parse_floats(tokens, values.data());
+                vertices_count = 0;
+                in_facet = true;
+            }
+            else if (token == "vertex") {
+                if (!in_facet || vertices_count == 3) {
+                    throw ParseException();
+                }
+
+                vertices_count++;
+                parse_floats(tokens, values.data() + 3 * vertices_count);
+            }
+            else if (token == "endfacet") {
+                if (!in_facet || vertices_count != 3) {
+                    throw ParseException();
+                }
+
+                const auto offset = this->parsed_records.size();
+                this->parsed_records.resize(offset + triangle_size);
+                std::memcpy(this->parsed_records.data() + offset, values.data(), sizeof(values));
+
+                in_facet = false;
+            }
+        }
+
+        if (in_facet) {
+            throw ParseException();
+        }
+
+        this->records = this->parsed_records.data();
+        this->count = this->parsed_records.size() / triangle_size;
+        this->swap_endian = false;
+    }
+
+    mesh::Triangle StlTriangleView::get_triangle(size_t index) const {
+        std::array<float, triangle_floats_count> values;
+        std::memcpy(values.data(), this->records + index * triangle_size, sizeof(values));
+
+        if (this->swap_endian) {
+            for (auto& value : values) {
+                utils::swap_endian(value);
+            }
+        }
+
+        return mesh::Triangle(
+            {
+                glm::vec3(values[3], values[4], values[5]),
+                glm::vec3(values[6], values[7], values[8]),
+                glm::vec3(values[9], values[10], values[11]),
+            },
+            std::nullopt,
+            std::nullopt,
+            glm::vec3(values[0], values[1], values[2])
+        );
+    }
+
+    std::shared_ptr<mesh::MeshLayout> StlTriangleView::build_layout(size_t threads, float weld_grid) const {
+        mesh::check_index_capacity(3 * this->count);
+
+        // Every corner its own vertex first
+        std::vector<glm::vec3> vertices;
+        mesh::FaceTable faces;
+
+        vertices.reserve(3 * this->count);
+        faces.offsets.resize(this->count + 1);
+        faces.vertices_indices.resize(3 * this->count);
+
+        for (size_t i = 0; i < this->count; i++) {
+            const auto triangle = this->get_triangle(i);
+            vertices.insert(vertices.end(), triangle.vertices().begin(), triangle.vertices().end());
+            faces.offsets[i + 1] = mesh::index_t(3 * (i + 1));
+        }
+
+        std::iota(faces.vertices_indices.begin(), faces.vertices_indices.end(), mesh::index_t(0));
+
+        // The soup is never shared, it is welded in place
+        calc::weld_vertices(vertices, faces, weld_grid, threads);
+
+        return std::make_shared<mesh::MeshLayout>(
+            std::move(vertices),
+            std::vector<glm::vec3> {},
+            std::vector<glm::vec2> {},
+            std::vector<glm::vec4> {},
+            std::move(faces)
+        );
+    }
+
+}
@@ -0,0 +1,251 @@
+#include "transform.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TRANSFORM_X86 1
+#include <immintrin.h>
+#endif
+
+namespace transform {
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "vertices are read as a flat array of floats");
+
+    // Vertices per iteration of the simd kernels
+    static constexpr size_t block_size = 8;
+
+    AffineMatrix get_point_matrix(glm::mat4 const& matrix) {
+        AffineMatrix rows {};
+
+        // glm matrices are indexed by column first
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++) {
+                rows[size_t(row)][size_t(column)] = matrix[column][row];
+            }
+        }
+
+        return rows;
+    }
+
+    AffineMatrix get_normal_matrix(glm::mat4 const& matrix) {
+        const auto a = glm::dvec3(glm::vec3(matrix[0]));
+        const auto b = glm::dvec3(glm::vec3(matrix[1]));
+        const auto c = glm::dvec3(glm::vec3(matrix[2]));
+
+        // Rows of the inverse are the cross products of the columns divided by the determinant,
+        // they are the columns of the inverse transpose
+        const std::array<glm::dvec3, 3> columns {
+            glm::dvec3(b.y * c.z - b.z * c.y, b.z * c.x - b.x * c.z, b.x * c.y - b.y * c.x),
+            glm::dvec3(c.y * a.z - c.z * a.y, c.z * a.x - c.x * a.z, c.x * a.y - c.y * a.x),
+            glm::dvec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x),
+        };
+
+        const double determinant = a.x * columns[0].x + a.y * columns[0].y + a.z * columns[0].z;
+
+        // A singular matrix has no inverse, the cofactors still give the directions, normals are normalized anyway
+        const double scale = determinant != 0 ? 1 / determinant : 1;
+
+        AffineMatrix rows {};
+
+        for (size_t column = 0; column < 3; column++) {
+            rows[0][column] = float(columns[column].x * scale);
+            rows[1][column] = float(columns[column].y * scale);
+            rows[2][column] = float(columns[column].z * scale);
+        }
+
+        return rows;
+    }
+
+    glm::vec3 transform_point(AffineMatrix const& matrix, glm::vec3 point) {
+        auto const& m = matrix;
+
+        return {
+            (m[0][0] * point.x + m[0][1] * point.y) + (m[0][2] * point.z + m[0][3]),
+            (m[1][0] * point.x + m[1][1] * point.y) + (m[1][2] * point.z + m[1][3]),
+            (m[2][0] * point.x + m[2][1] * point.y) + (m[2][2] * point.z + m[2][3]),
+        };
+    }
+
+    // The translation column of a normal matrix is zero, so the sums are rounded like transform_point's
+    static glm::vec3 transform_normal(AffineMatrix const& matrix, glm::vec3 normal) {
+        const auto v = transform_point(matrix, normal);
+        const float squared_length = v.x * v.x + v.y * v.y + v.z * v.z;
+
+        if (!(squared_length > 0)) {
+            return v;
+        }
+
+        const float inverse_length = 1.0f / std::sqrt(squared_length);
+        return {v.x * inverse_length, v.y * inverse_length, v.z * inverse_length};
+    }
+
+#ifdef TRANSFORM_X86
+    struct Axes {
+        __m256 x;
+        __m256 y;
+        __m256 z;
+    };
+
+    // Eight interleaved vertices into a register per axis. Each 128-bit half takes four vertices,
+    // the shuffles stay inside the halves
+    __attribute__((target("avx2")))
+    static Axes load_vertices_avx2(const float* input) {
+        auto m03 = _mm256_castps128_ps256(_mm_loadu_ps(input));
+        auto m14 = _mm256_castps128_ps256(_mm_loadu_ps(input + 4));
+        auto m25 = _mm256_castps128_ps256(_mm_loadu_ps(input + 8));
+        m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(input + 12), 1);
+        m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(input + 16), 1);
+        m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(input + 20), 1);
+
+        const auto xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+        const auto yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+
+        return {
+            _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0)),
+            _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)),
+            _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1)),
+        };
+    }
+
+    __attribute__((target("avx2")))
+    static void store_vertices_avx2(float* output, Axes const& axes) {
+        const auto xy = _mm256_shuffle_ps(axes.x, axes.y, _MM_SHUFFLE(2, 0, 2, 0));
+        const auto yz = _mm256_shuffle_ps(axes.y, axes.z, _MM_SHUFFLE(3, 1, 3, 1));
+        const auto zx = _mm256_shuffle_ps(axes.z, axes.x, _MM_SHUFFLE(3, 1, 2, 0));
+
+        const auto m03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+        const auto m14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+        const auto m25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+
+        _mm_storeu_ps(output, _mm256_castps256_ps128(m03));
+        _mm_storeu_ps(output + 4, _mm256_castps256_ps128(m14));
+        _mm_storeu_ps(output + 8, _mm256_castps256_ps128(m25));
+        _mm_storeu_ps(output + 12, _mm256_extractf128_ps(m03, 1));
+        _mm_storeu_ps(output + 16, _mm256_extractf128_ps(m14, 1));
+        _mm_storeu_ps(output + 20, _mm256_extractf128_ps(m25, 1));
+    }
+
+    // Without fused multiply-add, so the results are the ones of transform_point
+    __attribute__((target("avx2")))
+    static __m256 transform_row_avx2(std::array<float, 4> const& m, Axes const& axes) {
+        const auto xy = _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(m[0]), axes.x),
+            _mm256_mul_ps(_mm256_set1_ps(m[1]), axes.y)
+        );
+        const auto zw = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[2]), axes.z), _mm256_set1_ps(m[3]));
+
+        return _mm256_add_ps(xy, zw);
+    }
+
+    __attribute__((target("avx2")))
+    static Axes transform_axes_avx2(AffineMatrix const& matrix, Axes const& axes) {
+        return {
+            transform_row_avx2(matrix[0], axes),
+            transform_row_avx2(matrix[1], axes),
+            transform_row_avx2(matrix[2], axes),
+        };
+    }
+
+    // Blocks are loaded whole before they are stored, so output may be the input
+    __attribute__((target("avx2")))
+    static size_t transform_points_avx2(const float* input, float* output, size_t count, AffineMatrix const& matrix) {
+        size_t i = 0;
+
+        for (; i + block_size <= count; i += block_size) {
+            const auto axes = load_vertices_avx2(input + 3 * i);
+            store_vertices_avx2(output + 3 * i, transform_axes_avx2(matrix, axes));
+        }
+
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    static size_t transform_normals_avx2(const float* input, float* output, size_t count, AffineMatrix const& matrix) {
+        size_t i = 0;
+
+        for (; i + block_size <= count; i += block_size) {
+            const auto v = transform_axes_avx2(matrix, load_vertices_avx2(input + 3 * i));
+
+            const auto squared_length = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(v.x, v.x), _mm256_mul_ps(v.y, v.y)),
+                _mm256_mul_ps(v.z, v.z)
+            );
+            const auto inverse_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(squared_length));
+
+            // Zero normals are kept as they are instead of becoming nan
+            const auto non_zero = _mm256_cmp_ps(squared_length, _mm256_setzero_ps(), _CMP_GT_OQ);
+            const auto scale = _mm256_blendv_ps(_mm256_set1_ps(1.0f), inverse_length, non_zero);
+
+            store_vertices_avx2(output + 3 * i, {
+                _mm256_mul_ps(v.x, scale),
+                _mm256_mul_ps(v.y, scale),
+                _mm256_mul_ps(v.z, scale),
+            });
+        }
+
+        return i;
+    }
+#endif
+
+    bool is_supported(Isa isa) {
+        switch (isa) {
+            case Isa::Scalar:
+                return true;
+
+#ifdef TRANSFORM_X86
+            case Isa::Avx2:
+                return __builtin_cpu_supports("avx2");
+#endif
+
+            default:
+                return false;
+        }
+    }
+
+    Isa best_isa() {
+        static const Isa isa = [] {
+            if (is_supported(Isa::Avx2)) {
+                return Isa::Avx2;
+            }
+
+            return Isa::Scalar;
+        }();
+
+        return isa;
+    }
+
+    void transform_points(const glm::vec3* input, glm::vec3* output, size_t count, AffineMatrix const& matrix, Isa isa) {
+        size_t done = 0;
+
+#ifdef TRANSFORM_X86
+        if (isa == Isa::Avx2) {
+            done = transform_points_avx2(reinterpret_cast<const float*>(input), reinterpret_cast<float*>(output), count, matrix);
+        }
+#endif
+
+        // Tail of the simd kernel or everything. The output could alias a copy of the matrix held by the caller,
+        // a local one stays in registers
+        const auto local_matrix = matrix;
+
+        for (size_t i = done; i < count; i++) {
+            output[i] = transform_point(local_matrix, input[i]);
+        }
+    }
+
+    void transform_normals(const glm::vec3* input, glm::vec3* output, size_t count, AffineMatrix const& matrix, Isa isa) {
+        size_t done = 0;
+
+#ifdef TRANSFORM_X86
+        if (isa == Isa::Avx2) {
+            done = transform_normals_avx2(reinterpret_cast<const float*>(input), reinterpret_cast<float*>(output), count, matrix);
+        }
+#endif
+
+        const auto local_matrix = matrix;
+
+        for (size_t i = done; i < count; i++) {
+            output[i] = transform_normal(local_matrix, input[i]);
+        }
+    }
+
+}
@@ -1,9 +1,10 @@
 #include "mesh.hpp"
 #include <numeric>
+#include <iterator>
 
 namespace mesh {
-    std::vector<Triangle> DummyTriangulationStrategy::triangulate(Polygon &polygon) {
-        std::vector<size_t> indices(polygon.vertices.size());
+    std::vector<Triangle> DummyTriangulationStrategy::triangulate(Polygon const& polygon) {
+        std::vector<size_t> indices(polygon.vertices().size());
         std::vector<Triangle> triangles;
         std::iota(indices.begin(), indices.end(), 0);
 
@@ -11,22 +12,22 @@ namespace mesh {
             std::optional<std::array<glm::vec3, 3>> normals;
             std::optional<std::array<glm::vec2, 3>> tex_coords;
 
-            if (polygon.normals) {
+            if (polygon.normals()) {
                 normals = {
                     {
-                        polygon.normals.value()[indices[0]],
-                        polygon.normals.value()[indices[1]],
-                        polygon.normals.value()[indices[2]]
+                        polygon.normals().value()[indices[0]],
+                        polygon.normals().value()[indices[1]],
+                        polygon.normals().value()[indices[2]]
                     }
                 };
             }
 
-            if (polygon.tex_coords) {
+            if (polygon.tex_coords()) {
                 tex_coords = {
                     {
-                        polygon.tex_coords.value()[indices[0]],
-                        polygon.tex_coords.value()[indices[1]],
-                        polygon.tex_coords.value()[indices[2]]
+                        polygon.tex_coords().value()[indices[0]],
+                        polygon.tex_coords().value()[indices[1]],
+                        polygon.tex_coords().value()[indices[2]]
                     }
                 };
             }
@@ -35,9 +36,9 @@ namespace mesh {
                 {
                     Triangle(
                         {
-                            polygon.vertices[indices[0]],
-                            polygon.vertices[indices[1]],
-                            polygon.vertices[indices[2]]
+                            polygon.vertices()[indices[0]],
+                            polygon.vertices()[indices[1]],
+                            polygon.vertices()[indices[2]]
                         },
                         normals,
                         tex_coords,
@@ -51,4 +52,153 @@ namespace mesh {
 
         return triangles;
     }
+
+    void DummyTriangulationStrategy::triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) {
+        const auto first = layout.faces().offsets[face];
+        const auto last = layout.faces().offsets[face + 1];
+
+        for (auto corner = first + 1; corner + 1 < last; corner++) {
+            corners.push_back(first);
+            corners.push_back(corner);
+            corners.push_back(corner + 1);
+        }
+    }
+
+    std::unique_ptr<TriangulationStrategy> DummyTriangulationStrategy::clone() const {
+        return std::make_unique<DummyTriangulationStrategy>();
+    }
+
+    size_t TriangulationStrategy::triangulate_face_into(MeshLayout const& layout, size_t face, index_t* corners) {
+        std::vector<index_t> face_corners;
+        this->triangulate_face(layout, face, face_corners);
+
+        std::copy(face_corners.begin(), face_corners.end(), corners);
+        return face_corners.size() / 3;
+    }
+
+    void TriangulationStrategy::triangulate_into(Polygon const& polygon, std::vector<Triangle>& triangles) {
+        auto polygon_triangles = this->triangulate(polygon);
+
+        std::move(
+            polygon_triangles.begin(),
+            polygon_triangles.end(),
+            std::back_inserter(triangles)
+        );
+    }
+
+    // Triangle of the corners 0, corner and corner + 1
+    static Triangle get_fan_triangle(Polygon const& polygon, size_t corner) {
+        std::optional<std::array<glm::vec3, 3>> normals;
+        std::optional<std::array<glm::vec2, 3>> tex_coords;
+
+        if (polygon.normals()) {
+            auto const& polygon_normals = polygon.normals().value();
+            normals = {{polygon_normals[0], polygon_normals[corner], polygon_normals[corner + 1]}};
+        }
+
+        if (polygon.tex_coords()) {
+            auto const& polygon_tex_coords = polygon.tex_coords().value();
+            tex_coords = {{polygon_tex_coords[0], polygon_tex_coords[corner], polygon_tex_coords[corner + 1]}};
+        }
+
+        auto const& vertices = polygon.vertices();
+
+        return Triangle(
+            {vertices[0], vertices[corner], vertices[corner + 1]},
+            normals,
+            tex_coords,
+            std::nullopt
+        );
+    }
+
+    // Corners count is a compile time constant, so the loop is unrolled
+    template<size_t N>
+    static void append_fan(Polygon const& polygon, std::vector<Triangle>& triangles) {
+        for (size_t corner = 1; corner + 1 < N; corner++) {
+            triangles.push_back(get_fan_triangle(polygon, corner));
+        }
+    }
+
+    static void append_fan(Polygon const& polygon, size_t corners_count, std::vector<Triangle>& triangles) {
+        for (size_t corner = 1; corner + 1 < corners_count; corner++) {
+            triangles.push_back(get_fan_triangle(polygon, corner));
+        }
+    }
+
+    template<size_t N>
+    static void write_fan_corners(index_t first, index_t* corners) {
+        for (index_t corner = first + 1; corner + 1 < first + N; corner++) {
+            *corners++ = first;
+            *corners++ = corner;
+            *corners++ = corner + 1;
+        }
+    }
+
+    static void write_fan_corners(index_t first, index_t last, index_t* corners) {
+        for (index_t corner = first + 1; corner + 1 < last; corner++) {
+            *corners++ = first;
+            *corners++ = corner;
+            *corners++ = corner + 1;
+        }
+    }
+
+    std::vector<Triangle> FanTriangulationStrategy::triangulate(Polygon const& polygon) {
+        std::vector<Triangle> triangles;
+        triangles.reserve(polygon.vertices().size() >= 3 ? polygon.vertices().size() - 2 : 0);
+
+        this->triangulate_into(polygon, triangles);
+        return triangles;
+    }
+
+    void FanTriangulationStrategy::triangulate_into(Polygon const& polygon, std::vector<Triangle>& triangles) {
+        const auto corners_count = polygon.vertices().size();
+
+        switch (corners_count) {
+            case 3:
+                append_fan<3>(polygon, triangles);
+                break;
+
+            case 4:
+                append_fan<4>(polygon, triangles);
+                break;
+
+            default:
+                append_fan(polygon, corners_count, triangles);
+        }
+    }
+
+    void FanTriangulationStrategy::triangulate_face(MeshLayout const& layout, size_t face, std::vector<index_t>& corners) {
+        const auto corners_count = size_t(layout.faces().offsets[face + 1] - layout.faces().offsets[face]);
+
+        if (corners_count < 3) {
+            return;
+        }
+
+        const auto size = corners.size();
+        corners.resize(size + 3 * (corners_count - 2));
+        this->triangulate_face_into(layout, face, corners.data() + size);
+    }
+
+    size_t FanTriangulationStrategy::triangulate_face_into(MeshLayout const& layout, size_t face, index_t* corners) {
+        const auto first = layout.faces().offsets[face];
+        const auto last = layout.faces().offsets[face + 1];
+
+        switch (last - first) {
+            case 3:
+                write_fan_corners<3>(first, corners);
+                return 1;
+
+            case 4:
+                write_fan_corners<4>(first, corners);
+                return 2;
+
+            default:
+                write_fan_corners(first, last, corners);
+                return last - first >= 3 ? last - first - 2 : 0;
+        }
+    }
+
+    std::unique_ptr<TriangulationStrategy> FanTriangulationStrategy::clone() const {
+        return std::make_unique<FanTriangulationStrategy>();
+    }
 }
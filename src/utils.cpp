@@ -1,9 +1,15 @@
 #include "utils.hpp"
 
+#include <cmath>
 #include <iterator>
 #include <fstream>
 #include <sstream>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 namespace utils {
 
     std::vector<std::string> load_text_file_lines(std::string const& filepath) {
@@ -22,6 +28,57 @@ namespace utils {
         return std::move(lines);
     }
 
+    MappedFile::MappedFile(std::string const& filepath) {
+        const int fd = ::open(filepath.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+            throw std::ifstream::failure("can't open file '" + filepath + "'");
+        }
+
+        struct stat file_stat {};
+
+        if (::fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            throw std::ifstream::failure("can't stat file '" + filepath + "'");
+        }
+
+        this->length = static_cast<size_t>(file_stat.st_size);
+
+        // mmap doesn't accept zero length, an empty file is just an empty view
+        if (this->length > 0) {
+            this->data = ::mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (this->data == MAP_FAILED) {
+                this->data = nullptr;
+                ::close(fd);
+                throw std::ifstream::failure("can't map file '" + filepath + "'");
+            }
+
+            ::madvise(this->data, this->length, MADV_SEQUENTIAL);
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (this->data != nullptr) {
+            ::munmap(this->data, this->length);
+        }
+    }
+
+    std::string_view MappedFile::view() const {
+        if (this->data == nullptr) {
+            return {};
+        }
+
+        return std::string_view(static_cast<const char*>(this->data), this->length);
+    }
+
+    size_t MappedFile::size() const {
+        return this->length;
+    }
+
     // https://stackoverflow.com/questions/1001307/detecting-endianness-programmatically-in-a-c-program
     bool is_big_endian() {
         union {
@@ -36,13 +93,14 @@ namespace utils {
         return !is_big_endian();
     }
 
+    // glm::normalize spelled out, the batch kernels of normals::calculate_normals repeat exactly these operations
     glm::vec3 calculate_normal(glm::vec3 v1, glm::vec3 v2, glm::vec3 v3) {
         auto dir = glm::cross(v2 - v1, v3 - v1);
-        return glm::normalize(dir);
+        return dir * (1.0f / std::sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z));
     }
 
     glm::vec3 calculate_normal(mesh::Triangle const& triangle) {
-        return calculate_normal(triangle.vertices[0], triangle.vertices[1], triangle.vertices[2]);
+        return calculate_normal(triangle.vertices()[0], triangle.vertices()[1], triangle.vertices()[2]);
     }
 
     std::vector<std::string> split(std::string const& src, char delimiter) {
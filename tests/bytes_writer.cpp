@@ -180,3 +180,71 @@ TEST(BytesWriter, test_write_float_big_endian) {
         )
     );
 }
+
+static std::vector<std::byte> write_floats_one_by_one(mesh_format::ByteOrder byte_order, std::vector<float> const& values) {
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, byte_order);
+
+    for (const auto value : values) {
+        writer.write_float(value);
+    }
+
+    return writer.get_bytes();
+}
+
+TEST(BytesWriter, test_write_floats) {
+    const std::vector<float> values {1.f, -2.5f, 3e7f, 0.f, 1e-20f};
+
+    for (const auto byte_order : {mesh_format::ByteOrder::LittleEndian, mesh_format::ByteOrder::BigEndian}) {
+        mesh_format::BytesWriter writer(mesh_format::FileType::Binary, byte_order);
+        writer.write_floats(values.data(), values.size());
+
+        ASSERT_EQ(writer.get_bytes(), write_floats_one_by_one(byte_order, values));
+    }
+}
+
+TEST(BytesWriter, test_write_floats_big_endian) {
+    const std::vector<float> values {1.f, 2.f};
+
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, mesh_format::ByteOrder::BigEndian);
+    writer.write_floats(values.data(), values.size());
+
+    // 0x3f800000, 0x40000000
+    ASSERT_THAT(
+        writer.get_bytes(),
+        testing::ElementsAre(
+            std::byte(0x3f), std::byte(0x80), std::byte(0x0), std::byte(0x0),
+            std::byte(0x40), std::byte(0x0), std::byte(0x0), std::byte(0x0)
+        )
+    );
+}
+
+TEST(BytesWriter, test_write_record) {
+    const std::vector<float> values {1.f, 2.f, 3.f};
+
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, mesh_format::ByteOrder::LittleEndian);
+    writer.write_char('a');
+    writer.write_record(values.data(), values.size(), 2);
+    writer.write_char('b');
+
+    auto expected = write_floats_one_by_one(mesh_format::ByteOrder::LittleEndian, values);
+    expected.insert(expected.begin(), std::byte('a'));
+    expected.push_back(std::byte(0));
+    expected.push_back(std::byte(0));
+    expected.push_back(std::byte('b'));
+
+    ASSERT_EQ(writer.get_bytes(), expected);
+}
+
+TEST(BytesWriter, test_reserve) {
+    mesh_format::BytesWriter writer(mesh_format::FileType::Binary, mesh_format::ByteOrder::LittleEndian);
+    writer.reserve(1024);
+
+    const auto data = writer.get_bytes().data();
+
+    for (size_t i = 0; i < 256; i++) {
+        writer.write_float(float(i));
+    }
+
+    ASSERT_EQ(writer.get_bytes().data(), data);
+    ASSERT_EQ(writer.get_bytes().size(), 1024);
+}
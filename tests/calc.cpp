@@ -25,7 +25,7 @@ TEST(Calc, test_apply_transforms_to_layout_pos) {
     );
 
     ASSERT_THAT(
-        transformed_layout->vertices,
+        transformed_layout->vertices(),
         testing::ElementsAre(
             glm::vec3(11.000000, 1.000000, -1.000000),
             glm::vec3(11.000000, -1.000000, -1.000000),
@@ -52,7 +52,7 @@ TEST(Calc, test_apply_transforms_to_layout_scale) {
     );
 
     ASSERT_THAT(
-        transformed_layout->vertices,
+        transformed_layout->vertices(),
         testing::ElementsAre(
             glm::vec3(2.000000, 1.000000, -1.000000),
             glm::vec3(2.000000, -1.000000, -1.000000),
@@ -79,7 +79,7 @@ TEST(Calc, test_apply_transforms_to_layout_pos_and_scale) {
     );
 
     ASSERT_THAT(
-        transformed_layout->vertices,
+        transformed_layout->vertices(),
         testing::ElementsAre(
             glm::vec3(12.000000, 6.000000, -1.000000),
             glm::vec3(12.000000, 4.000000, -1.000000),
@@ -93,6 +93,54 @@ TEST(Calc, test_apply_transforms_to_layout_pos_and_scale) {
     );
 }
 
+TEST(Calc, test_apply_transforms_to_layout_shares_arrays) {
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/box.obj");
+
+    const auto translated_layout = calc::apply_transforms_to_layout(
+        layout,
+        glm::vec3(10, 0, 0),
+        glm::vec3(0, 0, 0),
+        glm::vec3(1, 1, 1)
+    );
+
+    ASSERT_EQ(translated_layout->shared_faces(), layout->shared_faces());
+    ASSERT_EQ(translated_layout->shared_tex_coords(), layout->shared_tex_coords());
+    ASSERT_EQ(translated_layout->shared_colors(), layout->shared_colors());
+    ASSERT_EQ(translated_layout->shared_normals(), layout->shared_normals());
+    ASSERT_NE(translated_layout->shared_vertices(), layout->shared_vertices());
+
+    // Scaled normals are new
+    const auto scaled_layout = calc::apply_transforms_to_layout(
+        layout,
+        glm::vec3(0, 0, 0),
+        glm::vec3(0, 0, 0),
+        glm::vec3(2, 1, 1)
+    );
+
+    ASSERT_EQ(scaled_layout->shared_faces(), layout->shared_faces());
+    ASSERT_NE(scaled_layout->shared_normals(), layout->shared_normals());
+}
+
+TEST(Calc, test_apply_transforms_to_layout_normals) {
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/box.obj");
+    const glm::vec3 rotation(float(utils::pi / 2), 0, 0);
+
+    // Rotation and uniform scale turn the normals like the surface and normalize them
+    const auto transformed_layout = calc::apply_transforms_to_layout(layout, glm::vec3(5, 0, 0), rotation, glm::vec3(3, 3, 3));
+    const auto rotation_matrix = calc::create_transform_matrix(glm::vec3(0, 0, 0), rotation, glm::vec3(1, 1, 1));
+
+    ASSERT_EQ(transformed_layout->normals().size(), layout->normals().size());
+
+    for (size_t i = 0; i < layout->normals().size(); i++) {
+        const auto expected = glm::vec3(rotation_matrix * glm::vec4(layout->normals()[i], 0.0f));
+        const auto normal = transformed_layout->normals()[i];
+
+        ASSERT_NEAR(normal.x, expected.x, 1e-5);
+        ASSERT_NEAR(normal.y, expected.y, 1e-5);
+        ASSERT_NEAR(normal.z, expected.z, 1e-5);
+    }
+}
+
 TEST(Calc, test_calculate_surface_area) {
     auto lines = utils::load_text_file_lines("../../tests/resources/box.obj");
     auto obj = obj_file::load_from_string_lines(lines);
@@ -109,6 +157,38 @@ TEST(Calc, test_calculate_volume) {
     ASSERT_NEAR(calc::calculate_volume(layout), 8.0, 0.5);
 }
 
+TEST(Calc, test_calculations_share_triangulation) {
+    auto lines = utils::load_text_file_lines("../../tests/resources/box.obj");
+    auto obj = obj_file::load_from_string_lines(lines);
+    auto layout = obj_file::create_mesh_layout_from_obj(obj);
+    mesh::FanTriangulationStrategy triangulation_strategy;
+
+    ASSERT_NEAR(calc::calculate_surface_area(layout), 24.0, 0.5);
+    const auto triangulation = layout->triangulation(triangulation_strategy);
+    ASSERT_NEAR(calc::calculate_volume(layout), 8.0, 0.5);
+    ASSERT_EQ(layout->triangulation(triangulation_strategy), triangulation);
+
+    // Identity transform keeps the layout
+    ASSERT_EQ(calc::apply_transforms_to_layout(layout, glm::vec3(0), glm::vec3(0), glm::vec3(1)), layout);
+
+    // Fan triangles don't depend on the positions, the transformed layout shares them
+    auto transformed_layout = calc::apply_transforms_to_layout(
+        layout,
+        glm::vec3(10, 0, 0),
+        glm::vec3(0, 0, 0),
+        glm::vec3(2, 2, 2)
+    );
+
+    ASSERT_NEAR(calc::calculate_volume(transformed_layout), 64.0, 0.5);
+    ASSERT_EQ(transformed_layout->triangulation(triangulation_strategy), triangulation);
+
+    // Ear clipping looks at the positions, the transformed layout is triangulated on its own
+    mesh::EarClippingTriangulationStrategy ear_clipping_strategy;
+    const auto ear_clipping_triangulation = layout->triangulation(ear_clipping_strategy);
+
+    ASSERT_NE(transformed_layout->triangulation(ear_clipping_strategy), ear_clipping_triangulation);
+}
+
 TEST(Calc, test_is_point_inside_mesh_inside) {
     auto lines = utils::load_text_file_lines("../../tests/resources/box.obj");
     auto obj = obj_file::load_from_string_lines(lines);
@@ -156,3 +236,127 @@ TEST(Calc, test_is_point_inside_mesh_outside_4) {
 
     ASSERT_FALSE(calc::is_point_inside_mesh(glm::vec3(0, -2, 0), layout));
 }
+
+// Two triangles per quad of a size x size grid, every corner its own vertex
+static std::shared_ptr<mesh::MeshLayout> grid_soup(size_t size) {
+    std::vector<glm::vec3> vertices;
+    mesh::FaceTable faces;
+
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            const glm::vec3 a(x, y, 0), b(x + 1, y, 0), c(x + 1, y + 1, 0), d(x, y + 1, 0);
+
+            for (auto const& triangle : {std::array<glm::vec3, 3> {a, b, c}, std::array<glm::vec3, 3> {a, c, d}}) {
+                for (auto const& vertex : triangle) {
+                    faces.push_index(mesh::index_t(vertices.size()), mesh::absent_index, mesh::absent_index, mesh::absent_index);
+                    vertices.push_back(vertex);
+                }
+
+                faces.end_face();
+            }
+        }
+    }
+
+    return std::make_shared<mesh::MeshLayout>(
+        std::move(vertices),
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+}
+
+TEST(Calc, test_apply_transforms_to_layout_threads) {
+    // Past the size split between threads
+    const auto layout = grid_soup(120);
+    const auto expected = calc::apply_transforms_to_layout(layout, glm::vec3(1, 2, 3), glm::vec3(0.5f, 0, 0), glm::vec3(2, 1, 3));
+
+    for (size_t threads : {2, 3, 8}) {
+        const auto transformed_layout = calc::apply_transforms_to_layout(
+            layout,
+            glm::vec3(1, 2, 3),
+            glm::vec3(0.5f, 0, 0),
+            glm::vec3(2, 1, 3),
+            threads
+        );
+
+        ASSERT_EQ(transformed_layout->vertices(), expected->vertices());
+    }
+}
+
+static std::vector<glm::vec3> face_positions(mesh::MeshLayout const& layout) {
+    std::vector<glm::vec3> positions;
+
+    for (const auto index : layout.faces().vertices_indices) {
+        positions.push_back(layout.vertices()[index]);
+    }
+
+    return positions;
+}
+
+TEST(Calc, test_weld_vertices) {
+    const auto soup = grid_soup(3);
+    const auto welded = calc::weld_vertices(soup);
+
+    ASSERT_EQ(soup->vertices().size(), 54);
+    ASSERT_EQ(welded->vertices().size(), 16);
+    ASSERT_EQ(welded->faces().offsets, soup->faces().offsets);
+    ASSERT_EQ(face_positions(*welded), face_positions(*soup));
+
+    // In order of the first occurrences
+    ASSERT_EQ(welded->vertices()[0], glm::vec3(0, 0, 0));
+    ASSERT_EQ(welded->vertices()[1], glm::vec3(1, 0, 0));
+    ASSERT_EQ(welded->vertices()[2], glm::vec3(1, 1, 0));
+    ASSERT_EQ(welded->vertices()[3], glm::vec3(0, 1, 0));
+
+    ASSERT_EQ(calc::calculate_surface_area(welded), calc::calculate_surface_area(soup));
+}
+
+TEST(Calc, test_weld_vertices_threads) {
+    const auto soup = grid_soup(200);
+    const auto sequential = calc::weld_vertices(soup, 0, 1);
+    const auto parallel = calc::weld_vertices(soup, 0, 4);
+
+    ASSERT_EQ(sequential->vertices().size(), 201 * 201);
+    ASSERT_EQ(parallel->vertices(), sequential->vertices());
+    ASSERT_EQ(parallel->faces().vertices_indices, sequential->faces().vertices_indices);
+}
+
+TEST(Calc, test_weld_vertices_in_place) {
+    const auto soup = grid_soup(3);
+    const auto welded = calc::weld_vertices(soup, 0.5f);
+
+    auto vertices = soup->vertices();
+    auto faces = soup->faces();
+    calc::weld_vertices(vertices, faces, 0.5f);
+
+    ASSERT_EQ(vertices, welded->vertices());
+    ASSERT_EQ(faces.vertices_indices, welded->faces().vertices_indices);
+    ASSERT_EQ(faces.offsets, soup->faces().offsets);
+}
+
+TEST(Calc, test_weld_vertices_grid) {
+    mesh::FaceTable faces;
+
+    for (mesh::index_t i = 0; i < 6; i++) {
+        faces.push_index(i, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    }
+
+    faces.end_face();
+
+    const auto layout = std::make_shared<mesh::MeshLayout>(
+        std::vector<glm::vec3> {
+            glm::vec3(0.1f, 0, 0), glm::vec3(0.1001f, 0, 0),
+            glm::vec3(0, 0, 0), glm::vec3(-0.0f, 0, 0),
+            glm::vec3(5, 5, 5), glm::vec3(5.0001f, 5, 5),
+        },
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    // Signed zeros weld even when exact
+    ASSERT_THAT(calc::weld_vertices(layout)->faces().vertices_indices, testing::ElementsAre(0, 1, 2, 2, 3, 4));
+    ASSERT_THAT(calc::weld_vertices(layout, 0.01f)->faces().vertices_indices, testing::ElementsAre(0, 0, 1, 1, 2, 2));
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <glm/glm.hpp>
+#include <fstream>
+#include <iterator>
+
+#include "obj.hpp"
+#include "stl.hpp"
+#include "calc.hpp"
+#include "convert.hpp"
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+static std::vector<char> read_file(std::string const& filepath) {
+    std::ifstream stream(filepath, std::ios::in | std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+static void test_stream_obj_to_stl(std::string const& input, glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale) {
+    const std::string output = "stream_generated.stl";
+    std::remove(output.c_str());
+
+    convert::stream_obj_to_stl(input, output, calc::create_transform_matrix(pos, rotation, scale));
+
+    auto layout = obj_file::create_mesh_layout_from_obj(obj_file::load_from_file(input));
+    auto transformed_layout = calc::apply_transforms_to_layout(layout, pos, rotation, scale);
+    auto writer = std::make_unique<stl_file::StlMeshWriter>();
+
+    ASSERT_EQ(read_file(output), writer->write(transformed_layout));
+}
+
+TEST(Convert, test_stream_obj_to_stl_box) {
+    test_stream_obj_to_stl(
+        "../../tests/resources/box.obj",
+        glm::vec3(0, 0, 0),
+        glm::vec3(0, 0, 0),
+        glm::vec3(1, 1, 1)
+    );
+}
+
+TEST(Convert, test_stream_obj_to_stl_complex) {
+    test_stream_obj_to_stl(
+        "../../tests/resources/complex.obj",
+        glm::vec3(0, 0, 0),
+        glm::vec3(0, 0, 0),
+        glm::vec3(1, 1, 1)
+    );
+}
+
+TEST(Convert, test_stream_obj_to_stl_transformed) {
+    test_stream_obj_to_stl(
+        "../../tests/resources/complex.obj",
+        glm::vec3(10, 5, 0),
+        glm::vec3(0.5, 0, 0),
+        glm::vec3(2, 1, 1)
+    );
+}
+
+TEST(Convert, test_stream_obj_to_stl_bad_index) {
+    std::ofstream("stream_bad_index.obj") << "v 0 0 0\nv 1 0 0\nf 1 2 3\n";
+    std::remove("stream_bad_index.stl");
+
+    EXPECT_THROW(
+        convert::stream_obj_to_stl("stream_bad_index.obj", "stream_bad_index.stl", glm::mat4(1)),
+        mesh::ValidationException
+    );
+
+    EXPECT_FALSE(std::ifstream("stream_bad_index.stl").good());
+}
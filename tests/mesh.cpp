@@ -38,7 +38,7 @@ TEST(MeshLayoutBuilder, test_flat_without_color) {
     auto layout = builder->build();
 
     ASSERT_THAT(
-        layout->vertices,
+        layout->vertices(),
         testing::ElementsAre(
             glm::vec3(1, 0, 0),
             glm::vec3(0, 1, 0),
@@ -47,7 +47,7 @@ TEST(MeshLayoutBuilder, test_flat_without_color) {
     );
 
     ASSERT_THAT(
-        layout->normals,
+        layout->normals(),
         testing::ElementsAre(
             glm::vec3(0.5, 0.5, 0),
             glm::vec3(1, 0.5, 0)
@@ -55,7 +55,7 @@ TEST(MeshLayoutBuilder, test_flat_without_color) {
     );
 
     ASSERT_THAT(
-        layout->tex_coords,
+        layout->tex_coords(),
         testing::ElementsAre(
             glm::vec2(0, 0),
             glm::vec2(0.5, 0.5),
@@ -64,32 +64,19 @@ TEST(MeshLayoutBuilder, test_flat_without_color) {
         )
     );
 
-    ASSERT_TRUE(layout->colors.empty());
-    ASSERT_EQ(layout->faces.size(), 2);
+    ASSERT_TRUE(layout->colors().empty());
+    ASSERT_FALSE(layout->faces().has_colors());
+    ASSERT_EQ(layout->faces().size(), 2);
 
-    ASSERT_THAT(layout->faces[0].vertices_indices, testing::ElementsAre(0, 1, 2));
-    ASSERT_THAT(layout->faces[0].normals_indices, testing::ElementsAre(0, 1, 0));
-    ASSERT_THAT(layout->faces[0].tex_coord_indices, testing::ElementsAre(0, 1, 2));
-    ASSERT_THAT(
-        layout->faces[0].color_indices,
-        testing::ElementsAre(
-            mesh::absent_index,
-            mesh::absent_index,
-            mesh::absent_index
-        )
-    );
+    ASSERT_THAT(layout->faces()[0].vertices_indices, testing::ElementsAre(0, 1, 2));
+    ASSERT_THAT(layout->faces()[0].normals_indices, testing::ElementsAre(0, 1, 0));
+    ASSERT_THAT(layout->faces()[0].tex_coord_indices, testing::ElementsAre(0, 1, 2));
+    ASSERT_TRUE(layout->faces()[0].color_indices.empty());
 
-    ASSERT_THAT(layout->faces[1].vertices_indices, testing::ElementsAre(2, 0, 0));
-    ASSERT_THAT(layout->faces[1].normals_indices, testing::ElementsAre(0, 1, 1));
-    ASSERT_THAT(layout->faces[1].tex_coord_indices, testing::ElementsAre(2, 3, 2));
-    ASSERT_THAT(
-        layout->faces[1].color_indices,
-        testing::ElementsAre(
-            mesh::absent_index,
-            mesh::absent_index,
-            mesh::absent_index
-        )
-    );
+    ASSERT_THAT(layout->faces()[1].vertices_indices, testing::ElementsAre(2, 0, 0));
+    ASSERT_THAT(layout->faces()[1].normals_indices, testing::ElementsAre(0, 1, 1));
+    ASSERT_THAT(layout->faces()[1].tex_coord_indices, testing::ElementsAre(2, 3, 2));
+    ASSERT_TRUE(layout->faces()[1].color_indices.empty());
 }
 
 TEST(MeshLayoutBuilder, test_vertex_coord_index_validation) {
@@ -208,7 +195,7 @@ TEST(MeshLayoutBuilder, test_triangle) {
     auto layout = builder->build();
 
     ASSERT_THAT(
-        layout->vertices,
+        layout->vertices(),
         testing::ElementsAre(
             glm::vec3(1, 0, 0),
             glm::vec3(0, 1, 0),
@@ -222,7 +209,7 @@ TEST(MeshLayoutBuilder, test_triangle) {
     );
 
     ASSERT_THAT(
-        layout->normals,
+        layout->normals(),
         testing::ElementsAre(
             glm::vec3(0, 0, 1),
             glm::vec3(0, 1, 0),
@@ -234,7 +221,7 @@ TEST(MeshLayoutBuilder, test_triangle) {
     );
 
     ASSERT_THAT(
-        layout->tex_coords,
+        layout->tex_coords(),
         testing::ElementsAre(
             glm::vec2(0, 0),
             glm::vec2(0, 1),
@@ -246,30 +233,91 @@ TEST(MeshLayoutBuilder, test_triangle) {
         )
     );
 
-    ASSERT_TRUE(layout->colors.empty());
-    ASSERT_EQ(layout->faces.size(), 2);
+    ASSERT_TRUE(layout->colors().empty());
+    ASSERT_FALSE(layout->faces().has_colors());
+    ASSERT_EQ(layout->faces().size(), 2);
+
+    ASSERT_THAT(layout->faces()[0].vertices_indices, testing::ElementsAre(0, 1, 2));
+    ASSERT_THAT(layout->faces()[0].normals_indices, testing::ElementsAre(0, 1, 2));
+    ASSERT_THAT(layout->faces()[0].tex_coord_indices, testing::ElementsAre(0, 1, 2));
+    ASSERT_TRUE(layout->faces()[0].color_indices.empty());
+
+    ASSERT_THAT(layout->faces()[1].vertices_indices, testing::ElementsAre(5, 6, 7));
+    ASSERT_THAT(layout->faces()[1].normals_indices, testing::ElementsAre(3, 4, 5));
+    ASSERT_THAT(layout->faces()[1].tex_coord_indices, testing::ElementsAre(4, 5, 6));
+    ASSERT_TRUE(layout->faces()[1].color_indices.empty());
+}
+
+TEST(MeshLayoutBuilder, test_face_table) {
+    auto builder = std::make_unique<mesh::MeshLayoutBuilder>();
+
+    builder->push_vertex(glm::vec3(1, 0, 0));
+    builder->push_vertex(glm::vec3(0, 1, 0));
+    builder->push_vertex(glm::vec3(0, 0, 1));
+    builder->push_vertex(glm::vec3(1, 1, 1));
+
+    builder->push_triplet(mesh::Triplet(0, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(1, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(2, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(3, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet_face();
+
+    builder->push_triplet(mesh::Triplet(3, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(2, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(1, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet_face();
+
+    auto layout = builder->build();
+
+    ASSERT_EQ(layout->faces().size(), 2);
+    ASSERT_EQ(layout->faces().indices_count(), 7);
+    ASSERT_THAT(layout->faces().offsets, testing::ElementsAre(0, 4, 7));
+    ASSERT_THAT(layout->faces()[1].vertices_indices, testing::ElementsAre(3, 2, 1));
+
+    mesh::FaceTable faces;
+    faces.push_faces(layout->faces());
+    faces.push_faces(layout->faces());
+
+    ASSERT_THAT(faces.offsets, testing::ElementsAre(0, 4, 7, 11, 14));
+    ASSERT_THAT(faces[3].vertices_indices, testing::ElementsAre(3, 2, 1));
+}
+
+TEST(MeshLayoutBuilder, test_sparse_channels) {
+    auto builder = std::make_unique<mesh::MeshLayoutBuilder>();
+
+    builder->push_vertex(glm::vec3(1, 0, 0));
+    builder->push_vertex(glm::vec3(0, 1, 0));
+    builder->push_vertex(glm::vec3(0, 0, 1));
+    builder->push_normal(glm::vec3(0, 0, 1));
+
+    builder->push_triplet(mesh::Triplet(0, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(1, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(2, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet_face();
+
+    builder->push_triplet(mesh::Triplet(2, mesh::absent_index, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(1, 0, mesh::absent_index));
+    builder->push_triplet(mesh::Triplet(0, 0, mesh::absent_index));
+    builder->push_triplet_face();
+
+    auto layout = builder->build();
+
+    ASSERT_TRUE(layout->faces().has_normals());
+    ASSERT_FALSE(layout->faces().has_tex_coords());
+    ASSERT_FALSE(layout->faces().has_colors());
 
-    ASSERT_THAT(layout->faces[0].vertices_indices, testing::ElementsAre(0, 1, 2));
-    ASSERT_THAT(layout->faces[0].normals_indices, testing::ElementsAre(0, 1, 2));
-    ASSERT_THAT(layout->faces[0].tex_coord_indices, testing::ElementsAre(0, 1, 2));
     ASSERT_THAT(
-        layout->faces[0].color_indices,
+        layout->faces().normals_indices,
         testing::ElementsAre(
             mesh::absent_index,
             mesh::absent_index,
-            mesh::absent_index
-        )
-    );
-
-    ASSERT_THAT(layout->faces[1].vertices_indices, testing::ElementsAre(5, 6, 7));
-    ASSERT_THAT(layout->faces[1].normals_indices, testing::ElementsAre(3, 4, 5));
-    ASSERT_THAT(layout->faces[1].tex_coord_indices, testing::ElementsAre(4, 5, 6));
-    ASSERT_THAT(
-        layout->faces[1].color_indices,
-        testing::ElementsAre(
             mesh::absent_index,
             mesh::absent_index,
-            mesh::absent_index
+            0,
+            0
         )
     );
+
+    ASSERT_TRUE(layout->faces()[0].tex_coord_indices.empty());
+    ASSERT_THAT(layout->faces()[1].normals_indices, testing::ElementsAre(mesh::absent_index, 0, 0));
 }
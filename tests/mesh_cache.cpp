@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <glm/glm.hpp>
+#include <fstream>
+#include <filesystem>
+
+#include "obj.hpp"
+#include "mesh_cache.hpp"
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+static void assert_layouts_eq(mesh::MeshLayout const& layout, mesh::MeshLayout const& expected) {
+    ASSERT_EQ(layout.vertices(), expected.vertices());
+    ASSERT_EQ(layout.normals(), expected.normals());
+    ASSERT_EQ(layout.tex_coords(), expected.tex_coords());
+    ASSERT_EQ(layout.colors(), expected.colors());
+    ASSERT_EQ(layout.faces().offsets, expected.faces().offsets);
+    ASSERT_EQ(layout.faces().vertices_indices, expected.faces().vertices_indices);
+    ASSERT_EQ(layout.faces().normals_indices, expected.faces().normals_indices);
+    ASSERT_EQ(layout.faces().tex_coord_indices, expected.faces().tex_coord_indices);
+    ASSERT_EQ(layout.faces().color_indices, expected.faces().color_indices);
+}
+
+TEST(MeshCache, test_write_read_complex) {
+    const std::string cache_path = "complex.meshcache";
+    const mesh_cache::SourceKey key {1, 2};
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+
+    mesh_cache::write_to_file(cache_path, key, *layout);
+    const auto cached = mesh_cache::read_from_file(cache_path, key);
+
+    ASSERT_NE(cached, nullptr);
+    assert_layouts_eq(*cached, *layout);
+}
+
+TEST(MeshCache, test_read_miss) {
+    const std::string cache_path = "box.meshcache";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/box.obj");
+
+    std::remove(cache_path.c_str());
+    EXPECT_EQ(mesh_cache::read_from_file(cache_path, {1, 2}), nullptr);
+
+    mesh_cache::write_to_file(cache_path, {1, 2}, *layout);
+    EXPECT_EQ(mesh_cache::read_from_file(cache_path, {1, 3}), nullptr);
+    EXPECT_EQ(mesh_cache::read_from_file(cache_path, {2, 2}), nullptr);
+    EXPECT_NE(mesh_cache::read_from_file(cache_path, {1, 2}), nullptr);
+}
+
+TEST(MeshCache, test_read_truncated) {
+    const std::string cache_path = "truncated.meshcache";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/box.obj");
+
+    mesh_cache::write_to_file(cache_path, {1, 2}, *layout);
+    std::filesystem::resize_file(cache_path, std::filesystem::file_size(cache_path) - 1);
+
+    EXPECT_THROW(mesh_cache::read_from_file(cache_path, {1, 2}), mesh_cache::CacheException);
+}
+
+TEST(MeshCache, test_read_overflowing_counts) {
+    const std::string cache_path = "overflowing.meshcache";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/box.obj");
+
+    mesh_cache::write_to_file(cache_path, {1, 2}, *layout);
+
+    // 2^62 more vertices take 3 * 2^64 more bytes, which wraps around to the same file size
+    const std::streamoff vertices_offset = 40;
+    std::fstream stream(cache_path, std::ios::in | std::ios::out | std::ios::binary);
+    uint64_t vertices = 0;
+
+    stream.seekg(vertices_offset);
+    stream.read(reinterpret_cast<char*>(&vertices), sizeof(vertices));
+    vertices += uint64_t(1) << 62;
+    stream.seekp(vertices_offset);
+    stream.write(reinterpret_cast<const char*>(&vertices), sizeof(vertices));
+    stream.close();
+
+    EXPECT_THROW(mesh_cache::read_from_file(cache_path, {1, 2}), mesh_cache::CacheException);
+    EXPECT_EQ(mesh_cache::load("overflowing", {1, 2}), nullptr);
+}
+
+TEST(MeshCache, test_read_invalid_indices) {
+    const std::string cache_path = "invalid.meshcache";
+
+    mesh::FaceTable faces;
+    faces.push_index(0, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.push_index(1, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.push_index(2, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.end_face();
+
+    const auto layout = std::make_shared<mesh::MeshLayout>(
+        std::vector<glm::vec3> { glm::vec3(0), glm::vec3(1) },
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    mesh_cache::write_to_file(cache_path, {1, 2}, *layout);
+
+    EXPECT_THROW(mesh_cache::read_from_file(cache_path, {1, 2}), mesh_cache::CacheException);
+}
+
+TEST(MeshCache, test_save_load) {
+    const std::string source_path = "cached.obj";
+
+    std::ofstream(source_path) << "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n";
+    std::remove(mesh_cache::get_cache_path(source_path).c_str());
+
+    const auto key = mesh_cache::get_source_key(source_path);
+    const auto layout = obj_file::load_mesh_layout_from_file(source_path);
+
+    EXPECT_EQ(mesh_cache::load(source_path, key), nullptr);
+
+    mesh_cache::save(source_path, key, *layout);
+    const auto cached = mesh_cache::load(source_path, key);
+
+    ASSERT_NE(cached, nullptr);
+    assert_layouts_eq(*cached, *layout);
+    EXPECT_FALSE(std::filesystem::exists(mesh_cache::get_cache_path(source_path) + ".tmp"));
+}
@@ -2,6 +2,7 @@
 #include <gmock/gmock.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <thread>
 
 #include "mesh.hpp"
 
@@ -368,3 +369,251 @@ TEST(MeshLayoutReader, test_polygons) {
         )
     );
 }
+
+// Fan that counts triangulated faces, to see when a layout triangulates again
+// Not read as a fan, so the readers go through the cached triangulation it counts the faces of
+class CountingFanStrategy : public mesh::DummyTriangulationStrategy {
+public:
+    size_t faces_count = 0;
+
+    [[nodiscard]] bool is_fan() const override { return false; }
+
+    void triangulate_face(mesh::MeshLayout const& layout, size_t face, std::vector<mesh::index_t>& corners) override {
+        this->faces_count += 1;
+        mesh::DummyTriangulationStrategy::triangulate_face(layout, face, corners);
+    }
+};
+
+static std::vector<mesh::Triangle> triangulate_polygons(mesh::MeshLayoutReader& reader) {
+    mesh::DummyTriangulationStrategy triangulation_strategy;
+    std::vector<mesh::Triangle> triangles;
+
+    for (auto const& polygon : reader.polygons()) {
+        for (auto const& triangle : triangulation_strategy.triangulate(polygon)) {
+            triangles.push_back(triangle);
+        }
+    }
+
+    return triangles;
+}
+
+TEST(MeshLayoutReader, test_triangle_range) {
+    auto layout = mesh_layout();
+    auto reader = std::make_unique<mesh::MeshLayoutReader>(layout, std::make_shared<mesh::DummyTriangulationStrategy>());
+    const auto range = reader->triangle_range();
+
+    ASSERT_EQ(std::vector<mesh::Triangle>(range.begin(), range.end()), triangulate_polygons(*reader));
+    ASSERT_EQ(range.size(), 5);
+    ASSERT_EQ(reader->triangles_count(), 5);
+
+    // Ranges of consecutive faces give consecutive triangles
+    std::vector<mesh::Triangle> triangles;
+
+    for (size_t face = 0; face < layout->faces().size(); face++) {
+        const mesh::TriangleRange face_range(*layout, face, face + 1);
+        triangles.insert(triangles.end(), face_range.begin(), face_range.end());
+    }
+
+    ASSERT_EQ(triangles, std::vector<mesh::Triangle>(range.begin(), range.end()));
+}
+
+TEST(MeshLayoutReader, test_triangle_range_sparse_faces) {
+    mesh::FaceTable faces;
+
+    // Too few corners, no triangles
+    faces.push_index(0, 0, mesh::absent_index, mesh::absent_index);
+    faces.push_index(1, 0, mesh::absent_index, mesh::absent_index);
+    faces.end_face();
+
+    // Partial normals are dropped like they are for polygons
+    faces.push_index(0, 0, mesh::absent_index, mesh::absent_index);
+    faces.push_index(1, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.push_index(2, 0, mesh::absent_index, mesh::absent_index);
+    faces.push_index(3, 0, mesh::absent_index, mesh::absent_index);
+    faces.end_face();
+
+    faces.end_face();
+
+    faces.push_index(3, 0, mesh::absent_index, mesh::absent_index);
+    faces.push_index(2, 0, mesh::absent_index, mesh::absent_index);
+    faces.push_index(1, 0, mesh::absent_index, mesh::absent_index);
+    faces.end_face();
+
+    auto layout = std::make_shared<mesh::MeshLayout>(
+        std::vector<glm::vec3> { glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 1, 0), glm::vec3(0, 1, 0) },
+        std::vector<glm::vec3> { glm::vec3(0, 0, 1) },
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    auto reader = std::make_unique<mesh::MeshLayoutReader>(layout, std::make_shared<mesh::DummyTriangulationStrategy>());
+    const auto range = reader->triangle_range();
+    const auto triangles = std::vector<mesh::Triangle>(range.begin(), range.end());
+
+    ASSERT_EQ(triangles, triangulate_polygons(*reader));
+    ASSERT_EQ(triangles.size(), 3);
+    ASSERT_EQ(range.size(), 3);
+    ASSERT_FALSE(triangles[0].normals());
+    ASSERT_TRUE(triangles[2].normals());
+}
+
+TEST(MeshLayoutReader, test_for_each_triangle) {
+    auto layout = mesh_layout();
+    auto reader = std::make_unique<mesh::MeshLayoutReader>(layout, std::make_shared<mesh::DummyTriangulationStrategy>());
+
+    std::vector<mesh::Triangle> triangles;
+
+    reader->for_each_triangle([&triangles](mesh::Triangle const& triangle) {
+        triangles.push_back(triangle);
+    });
+
+    ASSERT_EQ(triangles, triangulate_polygons(*reader));
+    ASSERT_EQ(reader->triangles(), triangles);
+    ASSERT_EQ(reader->triangles_count(), 5);
+}
+
+TEST(MeshLayoutReader, test_fan_triangles_on_the_fly) {
+    class CountingStrategy : public mesh::FanTriangulationStrategy {
+    public:
+        size_t faces_count = 0;
+
+        size_t triangulate_face_into(mesh::MeshLayout const& layout, size_t face, mesh::index_t* corners) override {
+            this->faces_count += 1;
+            return mesh::FanTriangulationStrategy::triangulate_face_into(layout, face, corners);
+        }
+    };
+
+    auto layout = mesh_layout();
+    auto triangulation_strategy = std::make_shared<CountingStrategy>();
+    auto reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+
+    // Fan triangles are made by TriangleRange, no triangulation is built
+    ASSERT_EQ(reader->triangles(), triangulate_polygons(*reader));
+    ASSERT_EQ(reader->parts_count(), layout->faces().size());
+    ASSERT_EQ(triangulation_strategy->faces_count, 0);
+}
+
+TEST(MeshLayoutReader, test_triangulation_cache) {
+    auto layout = mesh_layout();
+    auto triangulation_strategy = std::make_shared<CountingFanStrategy>();
+
+    auto first_reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+    auto second_reader = std::make_unique<mesh::MeshLayoutReader>(layout, triangulation_strategy);
+
+    ASSERT_EQ(first_reader->triangles(), second_reader->triangles());
+    ASSERT_EQ(triangulation_strategy->faces_count, 4);
+
+    // Another kind of strategy replaces the cache
+    mesh::DummyTriangulationStrategy dummy_strategy;
+    const auto dummy_triangulation = layout->triangulation(dummy_strategy);
+
+    ASSERT_NE(dummy_triangulation, layout->triangulation(*triangulation_strategy));
+    ASSERT_EQ(triangulation_strategy->faces_count, 8);
+}
+
+TEST(MeshLayoutReader, test_triangulation_cache_threads) {
+    auto layout = mesh_layout();
+    CountingFanStrategy triangulation_strategy;
+
+    std::vector<std::shared_ptr<const mesh::TriangleIndexBuffer>> triangulations(8);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < triangulations.size(); i++) {
+        threads.emplace_back([&layout, &triangulation_strategy, &triangulations, i] {
+            triangulations[i] = layout->triangulation(triangulation_strategy);
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(triangulation_strategy.faces_count, 4);
+
+    for (auto const& triangulation : triangulations) {
+        ASSERT_EQ(triangulation, triangulations.front());
+    }
+}
+
+// Quads in a row, every degenerate_every-th one with all corners in the same point
+static std::shared_ptr<mesh::MeshLayout> quads_layout(size_t faces_count, size_t degenerate_every) {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals { glm::vec3(0, 0, 1) };
+    mesh::FaceTable faces;
+
+    for (size_t face = 0; face < faces_count; face++) {
+        const auto x = float(face);
+        const auto degenerate = degenerate_every != 0 && face % degenerate_every == 0;
+        const auto first = mesh::index_t(vertices.size());
+
+        vertices.emplace_back(x, 0, 0);
+        vertices.emplace_back(degenerate ? x : x + 1, 0, 0);
+        vertices.emplace_back(degenerate ? x : x + 1, degenerate ? 0 : 1, 0);
+        vertices.emplace_back(x, degenerate ? 0 : 1, 0);
+
+        for (mesh::index_t i = 0; i < 4; i++) {
+            // Odd faces have no normals
+            faces.push_index(first + i, face % 2 == 0 ? 0 : mesh::absent_index, mesh::absent_index, mesh::absent_index);
+        }
+
+        faces.end_face();
+    }
+
+    return std::make_shared<mesh::MeshLayout>(
+        std::move(vertices),
+        std::move(normals),
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+}
+
+template<typename Strategy>
+static void assert_parallel_triangulation(size_t faces_count, size_t degenerate_every) {
+    Strategy triangulation_strategy;
+
+    const auto sequential = quads_layout(faces_count, degenerate_every)->triangulation(triangulation_strategy, 1);
+    const auto parallel = quads_layout(faces_count, degenerate_every)->triangulation(triangulation_strategy, 4);
+
+    ASSERT_EQ(parallel->corners, sequential->corners);
+    ASSERT_EQ(parallel->channels, sequential->channels);
+}
+
+TEST(MeshLayoutReader, test_triangulation_parallel) {
+    assert_parallel_triangulation<mesh::FanTriangulationStrategy>(20000, 0);
+    assert_parallel_triangulation<mesh::EarClippingTriangulationStrategy>(20000, 0);
+
+    // Ear clipping writes no triangles for degenerate faces, the gaps they leave are closed
+    assert_parallel_triangulation<mesh::EarClippingTriangulationStrategy>(20000, 7);
+
+    // Too few faces to split, triangulated on one thread
+    assert_parallel_triangulation<mesh::FanTriangulationStrategy>(100, 0);
+}
+
+TEST(MeshLayoutReader, test_triangulation_parallel_not_cloneable) {
+    // A strategy without clone triangulates on one thread
+    class NotCloneableStrategy : public CountingFanStrategy {
+    public:
+        [[nodiscard]] std::unique_ptr<mesh::TriangulationStrategy> clone() const override { return nullptr; }
+    } triangulation_strategy;
+
+    const auto layout = quads_layout(20000, 0);
+
+    const auto triangulation = layout->triangulation(triangulation_strategy, 4);
+
+    ASSERT_EQ(triangulation_strategy.faces_count, 20000);
+    ASSERT_EQ(triangulation->size(), 40000);
+}
+
+TEST(MeshLayoutReader, test_triangles_threads) {
+    const auto layout = quads_layout(20000, 0);
+    auto reader = std::make_unique<mesh::MeshLayoutReader>(layout, std::make_shared<mesh::FanTriangulationStrategy>(), 4);
+    auto single_thread_reader = std::make_unique<mesh::MeshLayoutReader>(
+        quads_layout(20000, 0),
+        std::make_shared<mesh::FanTriangulationStrategy>()
+    );
+
+    ASSERT_EQ(reader->triangles(), single_thread_reader->triangles());
+    ASSERT_EQ(reader->triangles_count(), 40000);
+}
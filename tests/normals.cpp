@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <random>
+
+#include "normals.hpp"
+#include "utils.hpp"
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+static std::vector<normals::Isa> supported_isas() {
+    std::vector<normals::Isa> isas;
+
+    for (auto isa : {normals::Isa::Scalar, normals::Isa::Avx2, normals::Isa::Avx512}) {
+        if (normals::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+
+    return isas;
+}
+
+static glm::vec3 get_corner(normals::TriangleBlock const& triangles, size_t corner, size_t lane) {
+    return {
+        triangles.corners[3 * corner][lane],
+        triangles.corners[3 * corner + 1][lane],
+        triangles.corners[3 * corner + 2][lane],
+    };
+}
+
+TEST(Normals, test_calculate_normals_matches_scalar) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+    normals::TriangleBlock triangles {};
+
+    for (size_t iteration = 0; iteration < 1000; iteration++) {
+        for (auto& lanes : triangles.corners) {
+            for (auto& value : lanes) {
+                value = coordinate(random);
+            }
+        }
+
+        for (auto isa : supported_isas()) {
+            normals::NormalBlock normals {};
+            normals::calculate_normals(triangles, normals, isa);
+
+            for (size_t lane = 0; lane < normals::block_size; lane++) {
+                const auto expected = utils::calculate_normal(
+                    get_corner(triangles, 0, lane),
+                    get_corner(triangles, 1, lane),
+                    get_corner(triangles, 2, lane)
+                );
+
+                ASSERT_FLOAT_EQ(normals.axes[0][lane], expected.x);
+                ASSERT_FLOAT_EQ(normals.axes[1][lane], expected.y);
+                ASSERT_FLOAT_EQ(normals.axes[2][lane], expected.z);
+            }
+        }
+    }
+}
+
+TEST(Normals, test_calculate_normals_axis_aligned) {
+    normals::TriangleBlock triangles {};
+
+    for (size_t lane = 0; lane < normals::block_size; lane++) {
+        // (0, 0, 0), (1, 0, 0), (0, 1, 0) moved along z
+        triangles.corners[2][lane] = float(lane);
+        triangles.corners[3][lane] = 1.0f;
+        triangles.corners[5][lane] = float(lane);
+        triangles.corners[7][lane] = 1.0f;
+        triangles.corners[8][lane] = float(lane);
+    }
+
+    for (auto isa : supported_isas()) {
+        normals::NormalBlock normals {};
+        normals::calculate_normals(triangles, normals, isa);
+
+        for (size_t lane = 0; lane < normals::block_size; lane++) {
+            ASSERT_EQ(normals.axes[0][lane], 0.0f);
+            ASSERT_EQ(normals.axes[1][lane], 0.0f);
+            ASSERT_EQ(normals.axes[2][lane], 1.0f);
+        }
+    }
+}
+
+TEST(Normals, test_best_isa_is_supported) {
+    ASSERT_TRUE(normals::is_supported(normals::best_isa()));
+    ASSERT_TRUE(normals::is_supported(normals::Isa::Scalar));
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <glm/glm.hpp>
+#include <fstream>
 
 #include "obj.hpp"
 #include "format.hpp"
@@ -16,7 +17,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     auto obj = obj_file::load_from_string_lines(lines);
 
     ASSERT_THAT(
-        obj.v,
+        obj.v(),
         testing::ElementsAre(
             glm::vec3(1.000000, 1.000000, -1.000000),
             glm::vec3(1.000000, -1.000000, -1.000000),
@@ -30,7 +31,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.vn,
+        obj.vn(),
         testing::ElementsAre(
             glm::vec3(0.0000, 1.0000, 0.0000),
             glm::vec3(0.0000, 0.0000, 1.0000),
@@ -42,7 +43,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.vt,
+        obj.vt(),
         testing::ElementsAre(
             glm::vec2(0.625000, 0.500000),
             glm::vec2(0.875000, 0.500000),
@@ -61,10 +62,10 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
         )
     );
 
-    ASSERT_EQ(obj.f.size(), 6);
+    ASSERT_EQ(obj.f().size(), 6);
 
     ASSERT_THAT(
-        obj.f[0].triplets,
+        obj.f()[0].triplets(),
         testing::ElementsAre(
             obj_file::Triplet(1, 1, 1),
             obj_file::Triplet(5, 2, 1),
@@ -74,7 +75,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.f[1].triplets,
+        obj.f()[1].triplets(),
         testing::ElementsAre(
             obj_file::Triplet(4, 5, 2),
             obj_file::Triplet(3, 4, 2),
@@ -84,7 +85,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.f[2].triplets,
+        obj.f()[2].triplets(),
         testing::ElementsAre(
             obj_file::Triplet(8, 8, 3),
             obj_file::Triplet(7, 9, 3),
@@ -94,7 +95,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.f[3].triplets,
+        obj.f()[3].triplets(),
         testing::ElementsAre(
             obj_file::Triplet(6, 12, 4),
             obj_file::Triplet(2, 13, 4),
@@ -104,7 +105,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.f[4].triplets,
+        obj.f()[4].triplets(),
         testing::ElementsAre(
             obj_file::Triplet(2, 13, 5),
             obj_file::Triplet(1, 1, 5),
@@ -114,7 +115,7 @@ TEST(ObjFileFormatTest, load_text_file_lines) {
     );
 
     ASSERT_THAT(
-        obj.f[5].triplets,
+        obj.f()[5].triplets(),
         testing::ElementsAre(
             obj_file::Triplet(6, 11, 6),
             obj_file::Triplet(5, 10, 6),
@@ -241,3 +242,221 @@ TEST(ObjFileFormatTest, test_create_mesh_layout_from_obj) {
         )
     );
 }
+
+TEST(ObjFileFormatTest, test_load_from_file) {
+    auto lines = utils::load_text_file_lines("../../tests/resources/complex.obj");
+    auto expected = obj_file::load_from_string_lines(lines);
+    auto obj = obj_file::load_from_file("../../tests/resources/complex.obj");
+
+    ASSERT_EQ(obj.v(), expected.v());
+    ASSERT_EQ(obj.vt(), expected.vt());
+    ASSERT_EQ(obj.vn(), expected.vn());
+    ASSERT_EQ(obj.f().size(), expected.f().size());
+
+    for (size_t i = 0; i < obj.f().size(); i++) {
+        ASSERT_EQ(obj.f()[i].triplets(), expected.f()[i].triplets());
+    }
+}
+
+TEST(ObjFileFormatTest, test_load_from_string_crlf) {
+    auto obj = obj_file::load_from_string("v 1 2 3\r\nv 4 5 6\r\nvn 0 0 1\r\nf 1//1 2//1 1//1");
+
+    ASSERT_THAT(obj.v(), testing::ElementsAre(glm::vec3(1, 2, 3), glm::vec3(4, 5, 6)));
+    ASSERT_THAT(obj.vn(), testing::ElementsAre(glm::vec3(0, 0, 1)));
+    ASSERT_EQ(obj.f().size(), 1);
+    ASSERT_THAT(
+        obj.f()[0].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(1, 0, 1),
+            obj_file::Triplet(2, 0, 1),
+            obj_file::Triplet(1, 0, 1)
+        )
+    );
+}
+
+TEST(ObjFileFormatTest, test_load_from_file_not_exists) {
+    EXPECT_THROW(obj_file::load_from_file("../../tests/resources/not_exists.obj"), std::ifstream::failure);
+}
+
+TEST(ObjFileFormatTest, test_triplet_forms) {
+    auto obj = obj_file::load_from_string(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0\n"
+        "vt 0 0\n"
+        "vt 1 1\n"
+        "vn 0 0 1\n"
+        "f 1 2 3\n"
+        "f 1/1 2/2 3/1\n"
+        "f 1//1 2//1 3//1\n"
+        "f 1/2/1 2/1/1 3/2/1\n"
+    );
+
+    ASSERT_EQ(obj.f().size(), 4);
+
+    ASSERT_THAT(
+        obj.f()[0].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(1, 0, 0),
+            obj_file::Triplet(2, 0, 0),
+            obj_file::Triplet(3, 0, 0)
+        )
+    );
+
+    ASSERT_THAT(
+        obj.f()[1].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(1, 1, 0),
+            obj_file::Triplet(2, 2, 0),
+            obj_file::Triplet(3, 1, 0)
+        )
+    );
+
+    ASSERT_THAT(
+        obj.f()[2].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(1, 0, 1),
+            obj_file::Triplet(2, 0, 1),
+            obj_file::Triplet(3, 0, 1)
+        )
+    );
+
+    ASSERT_THAT(
+        obj.f()[3].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(1, 2, 1),
+            obj_file::Triplet(2, 1, 1),
+            obj_file::Triplet(3, 2, 1)
+        )
+    );
+}
+
+TEST(ObjFileFormatTest, test_relative_indices) {
+    auto obj = obj_file::load_from_string(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0\n"
+        "vn 0 0 1\n"
+        "f -3//-1 -2//-1 -1//-1\n"
+        "v 1 1 0\n"
+        "f -3 -2 -1\n"
+    );
+
+    ASSERT_EQ(obj.f().size(), 2);
+
+    ASSERT_THAT(
+        obj.f()[0].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(1, 0, 1),
+            obj_file::Triplet(2, 0, 1),
+            obj_file::Triplet(3, 0, 1)
+        )
+    );
+
+    ASSERT_THAT(
+        obj.f()[1].triplets(),
+        testing::ElementsAre(
+            obj_file::Triplet(2, 0, 0),
+            obj_file::Triplet(3, 0, 0),
+            obj_file::Triplet(4, 0, 0)
+        )
+    );
+}
+
+TEST(ObjFileFormatTest, test_parse_floats) {
+    auto obj = obj_file::load_from_string(
+        "v 1 -2.5 +0.125\n"
+        "v 1.5e2 -2E-3 0.000001\n"
+        "v  123456789.5\t0.1234567891234 -1e-40\n"
+    );
+
+    ASSERT_THAT(
+        obj.v(),
+        testing::ElementsAre(
+            glm::vec3(1.0f, -2.5f, 0.125f),
+            glm::vec3(150.0f, -0.002f, 0.000001f),
+            glm::vec3(123456789.5f, 0.1234567891234f, -1e-40f)
+        )
+    );
+}
+
+TEST(ObjFileFormatTest, test_parse_errors) {
+    EXPECT_THROW(obj_file::load_from_string("v 1 2\n"), obj_file::ParseException);
+    EXPECT_THROW(obj_file::load_from_string("v 1 2 3 4\n"), obj_file::ParseException);
+    EXPECT_THROW(obj_file::load_from_string("v 1 2 abc\n"), obj_file::ParseException);
+    EXPECT_THROW(obj_file::load_from_string("v 1 2 3\nf 1/ 1 1\n"), obj_file::ParseException);
+    EXPECT_THROW(obj_file::load_from_string("v 1 2 3\nf 1/1/1/1 1 1\n"), obj_file::ParseException);
+    EXPECT_THROW(obj_file::load_from_string("v 1 2 3\nf -2 1 1\n"), obj_file::ParseException);
+    EXPECT_THROW(obj_file::load_from_string("v 1 2 3\nf 0 1 1\n"), obj_file::ParseException);
+}
+
+TEST(ObjFileFormatTest, test_load_from_string_parallel) {
+    const utils::MappedFile file("../../tests/resources/complex.obj");
+    auto expected = obj_file::load_from_string(file.view());
+    auto obj = obj_file::load_from_string(file.view(), 8);
+
+    ASSERT_EQ(obj.v(), expected.v());
+    ASSERT_EQ(obj.vt(), expected.vt());
+    ASSERT_EQ(obj.vn(), expected.vn());
+    ASSERT_EQ(obj.f().size(), expected.f().size());
+
+    for (size_t i = 0; i < obj.f().size(); i++) {
+        ASSERT_EQ(obj.f()[i].triplets(), expected.f()[i].triplets());
+    }
+}
+
+TEST(ObjFileFormatTest, test_load_from_string_parallel_relative_indices) {
+    std::string data = "v 0 0 0\nv 0 0 0\n";
+
+    // Large enough to be split into several chunks, every face refers to the vertices
+    // right before it, so faces at the beginning of a chunk refer to the previous one
+    for (size_t i = 0; i < 20000; i++) {
+        data += "v " + std::to_string(i) + " 0 0\n";
+        data += "vn 0 0 " + std::to_string(i) + "\n";
+        data += "f -1//-1 -2//-1 -3//-1\n";
+    }
+
+    auto expected = obj_file::load_from_string(data);
+    auto obj = obj_file::load_from_string(data, 8);
+
+    ASSERT_EQ(obj.v().size(), 20002);
+    ASSERT_EQ(obj.f().size(), 20000);
+
+    for (size_t i = 0; i < obj.f().size(); i++) {
+        ASSERT_EQ(obj.f()[i].triplets(), expected.f()[i].triplets());
+        ASSERT_THAT(
+            obj.f()[i].triplets(),
+            testing::ElementsAre(
+                obj_file::Triplet(i + 3, 0, i + 1),
+                obj_file::Triplet(i + 2, 0, i + 1),
+                obj_file::Triplet(i + 1, 0, i + 1)
+            )
+        );
+    }
+}
+
+static void assert_layouts_eq(mesh::MeshLayout const& layout, mesh::MeshLayout const& expected) {
+    ASSERT_EQ(layout.vertices(), expected.vertices());
+    ASSERT_EQ(layout.normals(), expected.normals());
+    ASSERT_EQ(layout.tex_coords(), expected.tex_coords());
+    ASSERT_EQ(layout.faces().offsets, expected.faces().offsets);
+    ASSERT_EQ(layout.faces().vertices_indices, expected.faces().vertices_indices);
+    ASSERT_EQ(layout.faces().normals_indices, expected.faces().normals_indices);
+    ASSERT_EQ(layout.faces().tex_coord_indices, expected.faces().tex_coord_indices);
+    ASSERT_EQ(layout.faces().color_indices, expected.faces().color_indices);
+}
+
+TEST(ObjFileFormatTest, test_load_mesh_layout_from_file) {
+    const std::string filepath = "../../tests/resources/complex.obj";
+    auto expected = obj_file::create_mesh_layout_from_obj(obj_file::load_from_file(filepath));
+
+    assert_layouts_eq(*obj_file::load_mesh_layout_from_file(filepath), *expected);
+    assert_layouts_eq(*obj_file::load_mesh_layout_from_file(filepath, 8), *expected);
+}
+
+TEST(ObjFileFormatTest, test_load_mesh_layout_validation) {
+    EXPECT_THROW(obj_file::load_mesh_layout_from_string("v 1 2 3\nf 1 2 1\n"), mesh::ValidationException);
+    EXPECT_THROW(obj_file::load_mesh_layout_from_string("v 1 2 3\nf 1//2 1 1\n"), mesh::ValidationException);
+    EXPECT_THROW(obj_file::load_mesh_layout_from_string("v 1 2 3\nf 4294967297 1 1\n"), mesh::ValidationException);
+    EXPECT_THROW(obj_file::load_mesh_layout_from_string("vn 1 2 3\n"), obj_file::StructIsException);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <random>
+
+#include "scan.hpp"
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+static std::vector<scan::Isa> supported_isas() {
+    std::vector<scan::Isa> isas;
+
+    for (auto isa : {scan::Isa::Scalar, scan::Isa::Sse2, scan::Isa::Avx2}) {
+        if (scan::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+
+    return isas;
+}
+
+static std::vector<std::string_view> scan_lines(std::string_view text, scan::Isa isa,
+                                                std::vector<std::vector<uint32_t>>& delimiters)
+{
+    scan::LineScanner scanner(text, isa);
+    std::vector<std::string_view> lines;
+    std::string_view line;
+    std::vector<uint32_t> line_delimiters;
+
+    while (scanner.next_line(line, line_delimiters)) {
+        lines.push_back(line);
+        delimiters.push_back(line_delimiters);
+    }
+
+    return lines;
+}
+
+TEST(Scan, test_classify_block_matches_scalar) {
+    std::mt19937 random(42);
+    const char alphabet[] = {'\n', ' ', '\t', '/', '1', 'v', '.', '-'};
+    char block[scan::block_size];
+
+    for (size_t iteration = 0; iteration < 1000; iteration++) {
+        for (auto& ch : block) {
+            ch = alphabet[random() % sizeof(alphabet)];
+        }
+
+        const auto expected = scan::classify_block(block, scan::Isa::Scalar);
+
+        for (auto isa : supported_isas()) {
+            const auto masks = scan::classify_block(block, isa);
+            ASSERT_EQ(masks.newlines, expected.newlines);
+            ASSERT_EQ(masks.spaces, expected.spaces);
+            ASSERT_EQ(masks.slashes, expected.slashes);
+        }
+    }
+}
+
+TEST(Scan, test_lines_and_delimiters) {
+    const std::string text = "v 1 2 3\n\nf 1/2 3//4\tx\nlast";
+
+    for (auto isa : supported_isas()) {
+        std::vector<std::vector<uint32_t>> delimiters;
+        const auto lines = scan_lines(text, isa, delimiters);
+
+        ASSERT_THAT(lines, testing::ElementsAre("v 1 2 3", "", "f 1/2 3//4\tx", "last"));
+        ASSERT_THAT(delimiters[0], testing::ElementsAre(1, 3, 5));
+        ASSERT_THAT(delimiters[1], testing::ElementsAre());
+        ASSERT_THAT(delimiters[2], testing::ElementsAre(1, 3, 5, 7, 8, 10));
+        ASSERT_THAT(delimiters[3], testing::ElementsAre());
+    }
+}
+
+TEST(Scan, test_lines_across_blocks) {
+    std::mt19937 random(7);
+    std::string text;
+
+    for (size_t i = 0; i < 5000; i++) {
+        const auto ch = random() % 10;
+        text += ch == 0 ? '\n' : ch == 1 ? ' ' : ch == 2 ? '/' : 'a';
+    }
+
+    std::vector<std::vector<uint32_t>> expected_delimiters;
+    std::vector<std::string_view> expected_lines;
+    size_t start = 0;
+
+    while (start <= text.size()) {
+        auto end = text.find('\n', start);
+
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        std::vector<uint32_t> line_delimiters;
+
+        for (size_t i = start; i < end; i++) {
+            if (text[i] == ' ' || text[i] == '/') {
+                line_delimiters.push_back(uint32_t(i - start));
+            }
+        }
+
+        if (end == text.size() && start == end) {
+            break;
+        }
+
+        expected_lines.push_back(std::string_view(text).substr(start, end - start));
+        expected_delimiters.push_back(line_delimiters);
+        start = end + 1;
+    }
+
+    for (auto isa : supported_isas()) {
+        std::vector<std::vector<uint32_t>> delimiters;
+        const auto lines = scan_lines(text, isa, delimiters);
+
+        ASSERT_EQ(lines, expected_lines);
+        ASSERT_EQ(delimiters, expected_delimiters);
+    }
+}
@@ -2,10 +2,15 @@
 #include <gmock/gmock.h>
 #include <glm/glm.hpp>
 #include <fstream>
+#include <sstream>
+#include <charconv>
+#include <cstring>
+#include <cmath>
 
 #include "obj.hpp"
 #include "stl.hpp"
 #include "utils.hpp"
+#include "calc.hpp"
 
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
@@ -41,3 +46,464 @@ TEST(StlMeshWriter, test_write_to_bytes_complex) {
 
     outfile.write(stl_bytes.data(), stl_bytes.size());
 }
+
+// Records the size of every chunk it receives
+class ChunksSink : public mesh_format::OutputSink {
+public:
+    std::vector<char> data;
+    std::vector<size_t> chunks;
+
+    void write(const std::byte* bytes, size_t size) override {
+        const auto chars = reinterpret_cast<const char*>(bytes);
+        this->data.insert(this->data.end(), chars, chars + size);
+        this->chunks.push_back(size);
+    }
+};
+
+static std::vector<char> read_file(std::string const& filepath) {
+    std::ifstream infile(filepath, std::ios::in | std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+}
+
+TEST(StlMeshWriter, test_write_to_sink_chunks) {
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    const auto expected = stl_file::StlMeshWriter().write(layout);
+
+    ChunksSink sink;
+    stl_file::StlMeshWriter().write(layout, sink);
+
+    ASSERT_EQ(sink.data, expected);
+    ASSERT_GT(sink.chunks.size(), 1);
+
+    // A chunk is flushed as soon as it reaches the chunk size, so it overshoots by less than a block of triangles
+    for (const auto size : sink.chunks) {
+        ASSERT_LT(size, mesh_format::sink_chunk_size + stl_file::StlMeshWriter::block_size * 50);
+    }
+}
+
+// Records the blocks, the per element writes go through the adapters of the base
+class BlocksWriter : public mesh_format::BatchMeshWriter<BlocksWriter> {
+public:
+    std::vector<size_t> triangle_blocks;
+    std::vector<size_t> vertex_blocks;
+    std::vector<mesh::Triangle> triangles;
+
+    BlocksWriter() : BatchMeshWriter(mesh_format::FileType::Binary, mesh_format::ByteOrder::LittleEndian) {}
+
+private:
+    friend class mesh_format::BatchMeshWriter<BlocksWriter>;
+
+    void write_layout() override {
+        this->write_vertices();
+        this->write_triangles();
+
+        // A single element through the virtual api
+        const auto triangle = this->triangles.front();
+        this->write_triangle(triangle);
+    }
+
+    void write_triangle_block(const mesh::Triangle* block, size_t count) {
+        this->triangle_blocks.push_back(count);
+        this->triangles.insert(this->triangles.end(), block, block + count);
+    }
+
+    void write_vertex_block(const glm::vec3* /*block*/, size_t count) {
+        this->vertex_blocks.push_back(count);
+    }
+};
+
+TEST(BatchMeshWriter, test_blocks) {
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    const auto expected = mesh::MeshLayoutReader(layout, std::make_shared<mesh::FanTriangulationStrategy>()).triangles();
+    const auto block_size = BlocksWriter::block_size;
+
+    BlocksWriter writer;
+    writer.write(layout);
+
+    // Full blocks, the tail, then the single triangle
+    ASSERT_EQ(writer.triangle_blocks.size(), (expected.size() + block_size - 1) / block_size + 1);
+    ASSERT_EQ(writer.triangle_blocks.back(), 1);
+    ASSERT_EQ(writer.triangles.size(), expected.size() + 1);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), writer.triangles.begin()));
+    ASSERT_EQ(writer.triangles.back(), expected.front());
+
+    for (size_t i = 0; i + 2 < writer.triangle_blocks.size(); i++) {
+        ASSERT_EQ(writer.triangle_blocks[i], block_size);
+    }
+
+    ASSERT_EQ(writer.vertex_blocks.size(), (layout->vertices().size() + block_size - 1) / block_size);
+}
+
+TEST(StlMeshWriter, test_write_to_file_sink) {
+    const std::string filepath = "complex_sink.stl";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    const auto expected = stl_file::StlMeshWriter().write(layout);
+
+    mesh_format::FileSink sink(filepath);
+    stl_file::StlMeshWriter().write(layout, sink);
+    sink.close();
+
+    ASSERT_EQ(read_file(filepath), expected);
+}
+
+TEST(FileSink, test_write_through_small_buffer) {
+    const std::string filepath = "small_buffer_sink.bin";
+    std::vector<std::byte> expected;
+
+    {
+        mesh_format::FileSink sink(filepath, 8);
+
+        // Smaller, equal and larger than the buffer
+        for (const size_t size : {3, 3, 8, 1, 20, 5, 7}) {
+            std::vector<std::byte> bytes(size);
+
+            for (auto& byte : bytes) {
+                byte = std::byte(expected.size() + (&byte - bytes.data()));
+            }
+
+            sink.write(bytes.data(), bytes.size());
+            expected.insert(expected.end(), bytes.begin(), bytes.end());
+        }
+
+        // Remaining bytes are flushed on destruction
+    }
+
+    const auto data = read_file(filepath);
+
+    ASSERT_EQ(data.size(), expected.size());
+    ASSERT_TRUE(std::equal(data.begin(), data.end(), expected.begin(), [](char ch, std::byte byte) {
+        return std::byte(ch) == byte;
+    }));
+}
+
+TEST(FileSink, test_open_failure) {
+    ASSERT_THROW(mesh_format::FileSink("missing_directory/out.stl"), std::ofstream::failure);
+}
+
+// Enough quads for several threads of the parallel encoder, tilted so the normals differ
+static std::shared_ptr<mesh::MeshLayout> quads_layout(size_t faces_count) {
+    std::vector<glm::vec3> vertices;
+    mesh::FaceTable faces;
+
+    for (size_t face = 0; face < faces_count; face++) {
+        const auto x = float(face);
+        const auto z = float(face % 7);
+        const auto first = mesh::index_t(vertices.size());
+
+        vertices.emplace_back(x, 0, 0);
+        vertices.emplace_back(x + 1, 0, z);
+        vertices.emplace_back(x + 1, 1, z);
+        vertices.emplace_back(x, 1, 0);
+
+        for (mesh::index_t i = 0; i < 4; i++) {
+            faces.push_index(first + i, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+        }
+
+        faces.end_face();
+    }
+
+    return std::make_shared<mesh::MeshLayout>(
+        std::move(vertices),
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+}
+
+static std::shared_ptr<mesh::TriangulationStrategy> fan_strategy() {
+    return std::make_shared<mesh::FanTriangulationStrategy>();
+}
+
+TEST(StlMeshWriter, test_write_parallel_to_memory) {
+    const auto layout = quads_layout(50000);
+    const auto expected = stl_file::StlMeshWriter().write(layout);
+
+    ASSERT_EQ(expected.size(), 84 + 50 * 100000);
+    ASSERT_EQ(stl_file::StlMeshWriter(fan_strategy(), 4).write(layout), expected);
+
+    // Other strategies are split by the triangles of the cached triangulation instead of the faces
+    const auto ear_clipping_strategy = std::make_shared<mesh::EarClippingTriangulationStrategy>();
+    ASSERT_EQ(
+        stl_file::StlMeshWriter(ear_clipping_strategy, 4).write(layout),
+        stl_file::StlMeshWriter(ear_clipping_strategy, 1).write(layout)
+    );
+}
+
+TEST(StlMeshWriter, test_write_parallel_to_file_sink) {
+    const std::string filepath = "quads_parallel.stl";
+    const auto layout = quads_layout(50000);
+    const auto expected = stl_file::StlMeshWriter().write(layout);
+
+    mesh_format::FileSink sink(filepath);
+    stl_file::StlMeshWriter(fan_strategy(), 3).write(layout, sink);
+    sink.close();
+
+    ASSERT_EQ(read_file(filepath), expected);
+}
+
+TEST(StlMeshWriter, test_write_parallel_to_sink_without_allocate) {
+    const auto layout = quads_layout(50000);
+    const auto expected = stl_file::StlMeshWriter().write(layout);
+
+    ChunksSink sink;
+    stl_file::StlMeshWriter(fan_strategy(), 4).write(layout, sink);
+
+    ASSERT_EQ(sink.data, expected);
+}
+
+TEST(FileSink, test_allocate) {
+    const std::string filepath = "allocate_sink.bin";
+    const std::vector<std::byte> head {std::byte(1), std::byte(2), std::byte(3)};
+    const std::vector<std::byte> tail {std::byte(4), std::byte(5)};
+
+    mesh_format::FileSink sink(filepath, 8);
+    sink.write(head.data(), head.size());
+
+    // Starts in the middle of a page and spans several of them
+    auto allocated = sink.allocate(10000);
+    ASSERT_NE(allocated, nullptr);
+
+    for (size_t i = 0; i < 10000; i++) {
+        allocated[i] = std::byte(i % 251);
+    }
+
+    sink.write(tail.data(), tail.size());
+    sink.close();
+
+    const auto data = read_file(filepath);
+
+    ASSERT_EQ(data.size(), 10005);
+    ASSERT_EQ(data[2], 3);
+    ASSERT_EQ(data[3 + 250], char(250));
+    ASSERT_EQ(data[3 + 9999], char(9999 % 251));
+    ASSERT_EQ(data[10004], 5);
+}
+
+static std::string to_string(std::vector<char> const& chars) {
+    return std::string(chars.begin(), chars.end());
+}
+
+TEST(StlTextMeshWriter, test_write_triangle) {
+    mesh::FaceTable faces;
+
+    for (mesh::index_t i = 0; i < 3; i++) {
+        faces.push_index(i, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    }
+
+    faces.end_face();
+
+    const auto layout = std::make_shared<mesh::MeshLayout>(
+        std::vector<glm::vec3> { glm::vec3(0, 0, 0), glm::vec3(1.5f, 0, 0), glm::vec3(0, 0.1f, -2e-7f) },
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    const auto normal = utils::calculate_normal(glm::vec3(0, 0, 0), glm::vec3(1.5f, 0, 0), glm::vec3(0, 0.1f, -2e-7f));
+    std::string normal_text;
+
+    for (size_t i = 0; i < 3; i++) {
+        std::array<char, 32> chars {};
+        normal_text += " " + std::string(chars.data(), std::to_chars(chars.data(), chars.data() + chars.size(), normal[i]).ptr);
+    }
+
+    ASSERT_EQ(
+        to_string(stl_file::StlTextMeshWriter().write(layout)),
+        "solid mesh\n"
+        "  facet normal" + normal_text + "\n"
+        "    outer loop\n"
+        "      vertex 0 0 0\n"
+        "      vertex 1.5 0 0\n"
+        "      vertex 0 0.1 -2e-07\n"
+        "    endloop\n"
+        "  endfacet\n"
+        "endsolid mesh\n"
+    );
+}
+
+// Every normal and vertex float of the text reads back to the float of the binary stl
+TEST(StlTextMeshWriter, test_round_trip_complex) {
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    const auto binary = stl_file::StlMeshWriter().write(layout);
+    const auto text = to_string(stl_file::StlTextMeshWriter().write(layout));
+
+    std::istringstream stream(text);
+    std::string token;
+    size_t offset = 84;
+    size_t floats_count = 0;
+
+    while (stream >> token) {
+        if (token != "normal" && token != "vertex") {
+            continue;
+        }
+
+        for (size_t i = 0; i < 3; i++) {
+            stream >> token;
+
+            float expected;
+            std::memcpy(&expected, binary.data() + offset, sizeof(float));
+            offset += sizeof(float);
+
+            const auto value = std::strtof(token.c_str(), nullptr);
+
+            if (std::isnan(expected)) {
+                ASSERT_TRUE(std::isnan(value));
+            }
+            else {
+                ASSERT_EQ(value, expected) << token;
+            }
+
+            floats_count++;
+        }
+
+        // Attribute byte count after the normal and 3 vertices
+        if (floats_count % 12 == 0) {
+            offset += 2;
+        }
+    }
+
+    ASSERT_EQ(offset, binary.size());
+}
+
+TEST(StlTextMeshWriter, test_write_parallel) {
+    const auto layout = quads_layout(50000);
+    const auto expected = stl_file::StlTextMeshWriter().write(layout);
+
+    ASSERT_EQ(stl_file::StlTextMeshWriter(fan_strategy(), 4).write(layout), expected);
+
+    ChunksSink sink;
+    stl_file::StlTextMeshWriter(fan_strategy(), 3).write(layout, sink);
+    ASSERT_EQ(sink.data, expected);
+
+    const std::string filepath = "quads_parallel_text.stl";
+    mesh_format::FileSink file_sink(filepath);
+    stl_file::StlTextMeshWriter(fan_strategy(), 4).write(layout, file_sink);
+    file_sink.close();
+    ASSERT_EQ(read_file(filepath), expected);
+
+    // Two threads take several batches, encoded while the previous ones are written
+    ASSERT_EQ(stl_file::StlTextMeshWriter(fan_strategy(), 2).write(layout), expected);
+}
+
+// Fails once it has received limit chunks
+class FailingSink : public mesh_format::OutputSink {
+public:
+    explicit FailingSink(size_t limit) : limit(limit) {
+        // Nothing
+    }
+
+    void write(const std::byte* /*bytes*/, size_t /*size*/) override {
+        if (this->chunks++ == this->limit) {
+            throw std::ofstream::failure("sink is full");
+        }
+    }
+
+private:
+    size_t limit;
+    size_t chunks = 0;
+};
+
+TEST(StlTextMeshWriter, test_write_parallel_sink_error) {
+    const auto layout = quads_layout(50000);
+
+    // The workers waiting for the failed writer are released and the error is rethrown
+    FailingSink sink(2);
+    ASSERT_THROW(stl_file::StlTextMeshWriter(fan_strategy(), 2).write(layout, sink), std::ofstream::failure);
+}
+
+static void write_file(std::string const& filepath, std::vector<char> const& data) {
+    std::ofstream outfile(filepath, std::ios::out | std::ios::binary);
+    outfile.write(data.data(), std::streamsize(data.size()));
+}
+
+static void assert_triangles_eq(stl_file::StlTriangleView const& triangles, mesh::MeshLayout const& layout) {
+    mesh::FanTriangulationStrategy triangulation_strategy;
+    const auto triangulation = layout.triangulation(triangulation_strategy);
+
+    ASSERT_EQ(triangles.size(), triangulation->size());
+
+    for (size_t i = 0; i < triangles.size(); i++) {
+        ASSERT_EQ(triangles.get_triangle(i).vertices(), triangulation->get_triangle(layout, i).vertices());
+    }
+}
+
+TEST(StlTriangleView, test_read_binary_complex) {
+    const std::string filepath = "complex_read.stl";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    write_file(filepath, stl_file::StlMeshWriter().write(layout));
+
+    const stl_file::StlTriangleView triangles(filepath);
+
+    assert_triangles_eq(triangles, *layout);
+
+    // The stored normal is the one the writer computed
+    const auto first = triangles.get_triangle(0);
+    ASSERT_EQ(first.normal(), utils::calculate_normal(first));
+
+    ASSERT_EQ(calc::calculate_surface_area(triangles), calc::calculate_surface_area(layout));
+    ASSERT_EQ(calc::calculate_volume(triangles), calc::calculate_volume(layout));
+    ASSERT_EQ(
+        calc::is_point_inside_mesh(glm::vec3(12, 11, 0), triangles),
+        calc::is_point_inside_mesh(glm::vec3(12, 11, 0), layout)
+    );
+}
+
+TEST(StlTriangleView, test_read_text_complex) {
+    const std::string filepath = "complex_read_text.stl";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    write_file(filepath, stl_file::StlTextMeshWriter().write(layout));
+
+    const stl_file::StlTriangleView triangles(filepath);
+
+    assert_triangles_eq(triangles, *layout);
+    ASSERT_EQ(calc::calculate_surface_area(triangles), calc::calculate_surface_area(layout));
+}
+
+TEST(StlTriangleView, test_build_layout_box) {
+    const stl_file::StlTriangleView triangles("../../tests/resources/box.stl");
+    const auto layout = triangles.build_layout();
+
+    ASSERT_EQ(triangles.size(), 12);
+    ASSERT_EQ(layout->vertices().size(), 8);
+    ASSERT_EQ(layout->faces().size(), 12);
+    assert_triangles_eq(triangles, *layout);
+
+    // Snapped to a grid while built, like welding the built layout
+    const auto welded = triangles.build_layout(1, 1.5f);
+
+    ASSERT_EQ(welded->vertices(), calc::weld_vertices(layout, 1.5f)->vertices());
+    ASSERT_EQ(welded->faces().vertices_indices, calc::weld_vertices(layout, 1.5f)->faces().vertices_indices);
+}
+
+TEST(StlTriangleView, test_read_invalid) {
+    const std::string truncated_path = "truncated.stl";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/box.obj");
+    auto data = stl_file::StlMeshWriter().write(layout);
+    data.pop_back();
+    write_file(truncated_path, data);
+
+    ASSERT_THROW(stl_file::StlTriangleView triangles(truncated_path), stl_file::ParseException);
+
+    const std::string unfinished_path = "unfinished.stl";
+    std::ofstream(unfinished_path) << "solid mesh\n  facet normal 0 0 1\n    outer loop\n      vertex 0 0 0\n";
+
+    ASSERT_THROW(stl_file::StlTriangleView triangles(unfinished_path), stl_file::ParseException);
+    ASSERT_THROW(stl_file::StlTriangleView triangles("missing.stl"), std::ifstream::failure);
+}
+
+TEST(StlTriangleView, test_build_layout_complex_threads) {
+    const std::string filepath = "complex_weld.stl";
+    const auto layout = obj_file::load_mesh_layout_from_file("../../tests/resources/complex.obj");
+    write_file(filepath, stl_file::StlMeshWriter().write(layout));
+
+    const stl_file::StlTriangleView triangles(filepath);
+    const auto sequential = triangles.build_layout(1);
+    const auto parallel = triangles.build_layout(4);
+
+    ASSERT_LE(sequential->vertices().size(), layout->vertices().size());
+    ASSERT_EQ(parallel->vertices(), sequential->vertices());
+    ASSERT_EQ(parallel->faces().vertices_indices, sequential->faces().vertices_indices);
+    assert_triangles_eq(triangles, *sequential);
+}
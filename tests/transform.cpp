@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <glm/glm.hpp>
+#include <random>
+
+#include "transform.hpp"
+#include "calc.hpp"
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+static std::vector<transform::Isa> supported_isas() {
+    std::vector<transform::Isa> isas;
+
+    for (auto isa : {transform::Isa::Scalar, transform::Isa::Avx2}) {
+        if (transform::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+
+    return isas;
+}
+
+static std::vector<glm::vec3> random_vectors(size_t count, std::mt19937& random) {
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    std::vector<glm::vec3> vectors;
+
+    for (size_t i = 0; i < count; i++) {
+        vectors.emplace_back(coordinate(random), coordinate(random), coordinate(random));
+    }
+
+    return vectors;
+}
+
+static const auto model_matrix = calc::create_transform_matrix(
+    glm::vec3(10, -5, 3),
+    glm::vec3(0.7f, 0, 0),
+    glm::vec3(2, 0.5f, 3)
+);
+
+TEST(Transform, test_point_matrix_matches_glm) {
+    const auto matrix = transform::get_point_matrix(model_matrix);
+    std::mt19937 random(42);
+
+    for (auto point : random_vectors(100, random)) {
+        const auto expected = glm::vec3(model_matrix * glm::vec4(point, 1.0f));
+        const auto result = transform::transform_point(matrix, point);
+
+        ASSERT_NEAR(result.x, expected.x, 1e-3);
+        ASSERT_NEAR(result.y, expected.y, 1e-3);
+        ASSERT_NEAR(result.z, expected.z, 1e-3);
+    }
+}
+
+TEST(Transform, test_transform_points_matches_scalar) {
+    const auto matrix = transform::get_point_matrix(model_matrix);
+    std::mt19937 random(42);
+
+    // Whole simd blocks and tails
+    for (size_t count = 0; count < 40; count++) {
+        const auto points = random_vectors(count, random);
+
+        for (auto isa : supported_isas()) {
+            std::vector<glm::vec3> output(count);
+            transform::transform_points(points.data(), output.data(), count, matrix, isa);
+
+            auto in_place = points;
+            transform::transform_points(in_place.data(), in_place.data(), count, matrix, isa);
+
+            for (size_t i = 0; i < count; i++) {
+                ASSERT_EQ(output[i], transform::transform_point(matrix, points[i]));
+            }
+
+            ASSERT_EQ(in_place, output);
+        }
+    }
+}
+
+TEST(Transform, test_transform_normals_matches_scalar) {
+    const auto matrix = transform::get_normal_matrix(model_matrix);
+    std::mt19937 random(42);
+    auto normals = random_vectors(37, random);
+    normals[3] = glm::vec3(0, 0, 0);
+    normals[20] = glm::vec3(0, 0, 0);
+
+    std::vector<glm::vec3> expected(normals.size());
+    transform::transform_normals(normals.data(), expected.data(), normals.size(), matrix, transform::Isa::Scalar);
+
+    for (auto isa : supported_isas()) {
+        std::vector<glm::vec3> output(normals.size());
+        transform::transform_normals(normals.data(), output.data(), normals.size(), matrix, isa);
+
+        ASSERT_EQ(output, expected);
+    }
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (normals[i] == glm::vec3(0, 0, 0)) {
+            ASSERT_EQ(expected[i], glm::vec3(0, 0, 0));
+        }
+        else {
+            ASSERT_NEAR(glm::dot(expected[i], expected[i]), 1.0f, 1e-5);
+        }
+    }
+}
+
+// Inverse transpose keeps the normals perpendicular to the transformed surface, the plain matrix doesn't
+TEST(Transform, test_normal_matrix_keeps_normals_perpendicular) {
+    const auto point_matrix = transform::get_point_matrix(model_matrix);
+    const auto normal_matrix = transform::get_normal_matrix(model_matrix);
+    const glm::vec3 origin(0, 0, 0);
+    std::mt19937 random(42);
+
+    for (auto normal : random_vectors(100, random)) {
+        // Some direction perpendicular to the normal
+        const auto tangent = glm::cross(normal, glm::vec3(1, 2, 3));
+
+        const auto transformed_tangent =
+            transform::transform_point(point_matrix, tangent) - transform::transform_point(point_matrix, origin);
+
+        glm::vec3 transformed_normal;
+        transform::transform_normals(&normal, &transformed_normal, 1, normal_matrix, transform::Isa::Scalar);
+
+        const auto cosine = glm::dot(transformed_normal, transformed_tangent) /
+            std::sqrt(glm::dot(transformed_tangent, transformed_tangent));
+
+        ASSERT_NEAR(cosine, 0.0f, 1e-4);
+    }
+}
+
+TEST(Transform, test_normal_matrix_mirror) {
+    const auto mirror = calc::create_transform_matrix(glm::vec3(0, 0, 0), glm::vec3(0, 0, 0), glm::vec3(-1, 2, 1));
+    const auto normal_matrix = transform::get_normal_matrix(mirror);
+    const glm::vec3 normals[] = {glm::vec3(1, 0, 0), glm::vec3(0, 1, 0)};
+    glm::vec3 result[2];
+
+    transform::transform_normals(normals, result, 2, normal_matrix, transform::Isa::Scalar);
+
+    ASSERT_EQ(result[0], glm::vec3(-1, 0, 0));
+    ASSERT_EQ(result[1], glm::vec3(0, 1, 0));
+}
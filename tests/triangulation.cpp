@@ -2,6 +2,7 @@
 #include <gmock/gmock.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <cmath>
 
 #include "mesh.hpp"
 
@@ -44,7 +45,7 @@ TEST(DummyTriangulationStrategy, test_triangulate) {
 
     ASSERT_EQ(triangles.size(), 2);
     ASSERT_THAT(
-        triangles[0].vertices,
+        triangles[0].vertices(),
         testing::ElementsAre(
             glm::vec3(0, 0, 0),
             glm::vec3(0, 1, 0),
@@ -53,7 +54,7 @@ TEST(DummyTriangulationStrategy, test_triangulate) {
     );
 
     ASSERT_THAT(
-        triangles[1].vertices,
+        triangles[1].vertices(),
         testing::ElementsAre(
             glm::vec3(0, 0, 0),
             glm::vec3(1, 1, 0),
@@ -61,3 +62,331 @@ TEST(DummyTriangulationStrategy, test_triangulate) {
         )
     );
 }
+
+// Regular n-gon in the xy plane with per corner normals and tex coords
+static mesh::Polygon regular_polygon(size_t corners_count) {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> tex_coords;
+
+    for (size_t i = 0; i < corners_count; i++) {
+        const auto angle = 2.0f * 3.14159265f * float(i) / float(corners_count);
+
+        vertices.emplace_back(std::cos(angle), std::sin(angle), 0);
+        normals.emplace_back(0, 0, float(i));
+        tex_coords.emplace_back(float(i), 0);
+    }
+
+    return mesh::Polygon(vertices, normals, tex_coords);
+}
+
+TEST(FanTriangulationStrategy, test_triangulate_same_as_dummy) {
+    mesh::DummyTriangulationStrategy dummy_strategy;
+    mesh::FanTriangulationStrategy fan_strategy;
+
+    for (size_t corners_count = 3; corners_count <= 10; corners_count++) {
+        const auto polygon = regular_polygon(corners_count);
+        const auto triangles = fan_strategy.triangulate(polygon);
+
+        ASSERT_EQ(triangles.size(), corners_count - 2);
+        ASSERT_EQ(triangles, dummy_strategy.triangulate(polygon));
+    }
+}
+
+TEST(FanTriangulationStrategy, test_triangulate_without_channels) {
+    mesh::FanTriangulationStrategy fan_strategy;
+
+    const auto polygon = mesh::Polygon(
+        { glm::vec3(0, 0, 0), glm::vec3(0, 1, 0), glm::vec3(1, 1, 0), glm::vec3(1, 0, 0) },
+        std::nullopt,
+        std::nullopt,
+        std::nullopt
+    );
+
+    const auto triangles = fan_strategy.triangulate(polygon);
+
+    ASSERT_EQ(triangles.size(), 2);
+    ASSERT_FALSE(triangles[0].normals());
+    ASSERT_FALSE(triangles[1].tex_coords());
+    ASSERT_THAT(
+        triangles[1].vertices(),
+        testing::ElementsAre(
+            glm::vec3(0, 0, 0),
+            glm::vec3(1, 1, 0),
+            glm::vec3(1, 0, 0)
+        )
+    );
+}
+
+TEST(FanTriangulationStrategy, test_triangulate_into) {
+    mesh::FanTriangulationStrategy fan_strategy;
+    std::vector<mesh::Triangle> triangles;
+
+    fan_strategy.triangulate_into(regular_polygon(3), triangles);
+    fan_strategy.triangulate_into(regular_polygon(5), triangles);
+
+    ASSERT_EQ(triangles.size(), 4);
+    ASSERT_EQ(triangles[3], fan_strategy.triangulate(regular_polygon(5))[2]);
+}
+
+TEST(FanTriangulationStrategy, test_triangulate_face) {
+    mesh::FaceTable faces;
+
+    // Triangle, quad, pentagon and a degenerate face with two corners
+    for (size_t corners_count : {3, 4, 5, 2}) {
+        for (size_t i = 0; i < corners_count; i++) {
+            faces.push_index(mesh::index_t(i), mesh::absent_index, mesh::absent_index, mesh::absent_index);
+        }
+
+        faces.end_face();
+    }
+
+    const mesh::MeshLayout layout(
+        std::vector<glm::vec3>(5),
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    mesh::DummyTriangulationStrategy dummy_strategy;
+    mesh::FanTriangulationStrategy fan_strategy;
+
+    for (size_t face = 0; face < layout.faces().size(); face++) {
+        std::vector<mesh::index_t> dummy_corners;
+        std::vector<mesh::index_t> fan_corners;
+
+        dummy_strategy.triangulate_face(layout, face, dummy_corners);
+        fan_strategy.triangulate_face(layout, face, fan_corners);
+
+        ASSERT_EQ(fan_corners, dummy_corners);
+    }
+
+    std::vector<mesh::index_t> corners;
+    fan_strategy.triangulate_face(layout, 1, corners);
+
+    ASSERT_THAT(corners, testing::ElementsAre(3, 4, 5, 3, 5, 6));
+}
+
+// Star with alternating outer and inner radius, every inner corner is reflex
+static std::vector<glm::vec3> star_points(size_t corners_count) {
+    std::vector<glm::vec3> points;
+
+    for (size_t i = 0; i < corners_count; i++) {
+        const auto angle = 2.0f * 3.14159265f * float(i) / float(corners_count);
+        const auto radius = i % 2 == 0 ? 1.0f : 0.4f;
+
+        points.emplace_back(radius * std::cos(angle), radius * std::sin(angle), 0);
+    }
+
+    return points;
+}
+
+// Comb of teeth along x, concave between every two teeth
+static std::vector<glm::vec3> comb_points(size_t teeth_count) {
+    std::vector<glm::vec3> points;
+
+    for (size_t i = 0; i < teeth_count; i++) {
+        points.emplace_back(float(2 * i), 0, 1);
+        points.emplace_back(float(2 * i + 1), 0, 1);
+        points.emplace_back(float(2 * i + 1), 0, 10);
+        points.emplace_back(float(2 * i + 2), 0, 10);
+    }
+
+    // Base is subdivided under the teeth, like outlines of real facades
+    for (size_t i = 2 * teeth_count + 1; i > 0; i--) {
+        points.emplace_back(float(i - 1), 0, 0);
+    }
+
+    return points;
+}
+
+// Newell normal, its length is twice the polygon area
+static glm::vec3 polygon_normal(std::vector<glm::vec3> const& points) {
+    glm::vec3 normal(0);
+
+    for (size_t i = 0; i < points.size(); i++) {
+        const auto current = points[i];
+        const auto next = points[(i + 1) % points.size()];
+
+        normal.x += (current.y - next.y) * (current.z + next.z);
+        normal.y += (current.z - next.z) * (current.x + next.x);
+        normal.z += (current.x - next.x) * (current.y + next.y);
+    }
+
+    return normal;
+}
+
+// Triangles cover the polygon exactly once and keep its winding
+static void assert_covers_polygon(std::vector<glm::vec3> const& points, std::vector<mesh::Triangle> const& triangles) {
+    const auto normal = polygon_normal(points);
+    double area = 0;
+
+    for (auto const& triangle : triangles) {
+        const auto v = triangle.vertices();
+        const auto triangle_normal = glm::cross(v[1] - v[0], v[2] - v[0]);
+
+        ASSERT_GE(glm::dot(triangle_normal, normal), 0);
+        area += 0.5 * glm::length(triangle_normal);
+    }
+
+    ASSERT_EQ(triangles.size(), points.size() - 2);
+    ASSERT_NEAR(area, 0.5 * glm::length(normal), 1e-3 * area);
+}
+
+TEST(EarClippingTriangulationStrategy, test_triangulate_convex) {
+    mesh::EarClippingTriangulationStrategy ear_clipping_strategy;
+
+    for (size_t corners_count = 3; corners_count <= 10; corners_count++) {
+        const auto polygon = regular_polygon(corners_count);
+        assert_covers_polygon(polygon.vertices(), ear_clipping_strategy.triangulate(polygon));
+    }
+}
+
+TEST(EarClippingTriangulationStrategy, test_triangulate_concave) {
+    mesh::EarClippingTriangulationStrategy ear_clipping_strategy;
+    const auto points = star_points(10);
+
+    const auto triangles = ear_clipping_strategy.triangulate(mesh::Polygon(points, std::nullopt, std::nullopt, std::nullopt));
+    assert_covers_polygon(points, triangles);
+
+    // Reversed winding is kept as well
+    const std::vector<glm::vec3> reversed_points(points.rbegin(), points.rend());
+    const auto reversed_triangles = ear_clipping_strategy.triangulate(
+        mesh::Polygon(reversed_points, std::nullopt, std::nullopt, std::nullopt)
+    );
+
+    assert_covers_polygon(reversed_points, reversed_triangles);
+}
+
+TEST(EarClippingTriangulationStrategy, test_triangulate_keeps_channels) {
+    mesh::EarClippingTriangulationStrategy ear_clipping_strategy;
+    const auto points = star_points(6);
+
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> tex_coords;
+
+    for (auto const& point : points) {
+        normals.push_back(point);
+        tex_coords.emplace_back(point.x, point.y);
+    }
+
+    for (auto const& triangle : ear_clipping_strategy.triangulate(mesh::Polygon(points, normals, tex_coords))) {
+        ASSERT_EQ(triangle.normals().value(), triangle.vertices());
+
+        for (size_t i = 0; i < 3; i++) {
+            ASSERT_EQ(triangle.tex_coords().value()[i], glm::vec2(triangle.vertices()[i].x, triangle.vertices()[i].y));
+        }
+    }
+}
+
+TEST(EarClippingTriangulationStrategy, test_triangulate_large_concave) {
+    mesh::EarClippingTriangulationStrategy ear_clipping_strategy;
+
+    // Vertical plane, points inside ears are looked up in the grid
+    const auto comb = comb_points(5000);
+    assert_covers_polygon(
+        comb,
+        ear_clipping_strategy.triangulate(mesh::Polygon(comb, std::nullopt, std::nullopt, std::nullopt))
+    );
+
+    const auto star = star_points(20000);
+    assert_covers_polygon(
+        star,
+        ear_clipping_strategy.triangulate(mesh::Polygon(star, std::nullopt, std::nullopt, std::nullopt))
+    );
+}
+
+TEST(EarClippingTriangulationStrategy, test_triangulate_face) {
+    const auto points = comb_points(100);
+    mesh::FaceTable faces;
+
+    // Face in the middle of the table, corners are relative to the whole table
+    faces.push_index(0, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.push_index(1, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.push_index(2, mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    faces.end_face();
+
+    for (size_t i = 0; i < points.size(); i++) {
+        faces.push_index(mesh::index_t(i), mesh::absent_index, mesh::absent_index, mesh::absent_index);
+    }
+
+    faces.end_face();
+
+    const mesh::MeshLayout layout(
+        points,
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    mesh::EarClippingTriangulationStrategy ear_clipping_strategy;
+    std::vector<mesh::index_t> corners;
+    ear_clipping_strategy.triangulate_face(layout, 1, corners);
+
+    ASSERT_EQ(corners.size(), 3 * (points.size() - 2));
+
+    std::vector<mesh::Triangle> triangles;
+
+    for (size_t i = 0; i < corners.size(); i += 3) {
+        ASSERT_GE(corners[i], 3);
+
+        triangles.emplace_back(
+            std::array<glm::vec3, 3> {
+                points[corners[i] - 3],
+                points[corners[i + 1] - 3],
+                points[corners[i + 2] - 3]
+            },
+            std::nullopt,
+            std::nullopt,
+            std::nullopt
+        );
+    }
+
+    assert_covers_polygon(points, triangles);
+}
+
+// Corners written to a buffer are the ones appended to a vector
+template<typename Strategy>
+static void assert_triangulate_face_into(mesh::MeshLayout const& layout) {
+    Strategy triangulation_strategy;
+
+    for (size_t face = 0; face < layout.faces().size(); face++) {
+        std::vector<mesh::index_t> corners;
+        triangulation_strategy.triangulate_face(layout, face, corners);
+
+        const auto face_size = layout.faces()[face].size();
+        std::vector<mesh::index_t> buffer(3 * (face_size - 2), mesh::absent_index);
+        const auto count = triangulation_strategy.triangulate_face_into(layout, face, buffer.data());
+
+        ASSERT_EQ(3 * count, corners.size());
+        buffer.resize(3 * count);
+        ASSERT_EQ(buffer, corners);
+    }
+}
+
+TEST(TriangulationStrategy, test_triangulate_face_into) {
+    const auto points = comb_points(10);
+    mesh::FaceTable faces;
+
+    for (const size_t face_size : {size_t(3), size_t(4), size_t(5), points.size()}) {
+        for (size_t i = 0; i < face_size; i++) {
+            faces.push_index(mesh::index_t(i), mesh::absent_index, mesh::absent_index, mesh::absent_index);
+        }
+
+        faces.end_face();
+    }
+
+    const mesh::MeshLayout layout(
+        points,
+        std::vector<glm::vec3> {},
+        std::vector<glm::vec2> {},
+        std::vector<glm::vec4> {},
+        std::move(faces)
+    );
+
+    assert_triangulate_face_into<mesh::DummyTriangulationStrategy>(layout);
+    assert_triangulate_face_into<mesh::FanTriangulationStrategy>(layout);
+    assert_triangulate_face_into<mesh::EarClippingTriangulationStrategy>(layout);
+}